@@ -0,0 +1,138 @@
+#include "AttackTables.h"
+#include "BitboardGenerator.h"
+#include <vector>
+
+AttackTables attackTables;
+
+// The seeds of the magic number search of the squares of each rank (found offline to make the search take milliseconds)
+static const uint64_t MAGIC_SEEDS[8] = { 728, 2985, 110, 2501, 1289, 2821, 1699, 255 };
+
+// Count the set bits (the tables are built once, so this does not need the POPCNT instruction)
+static int countBits(uint64_t bitboard)
+{
+	int count = 0;
+	for (; bitboard; bitboard &= bitboard - 1)
+		count++;
+	return count;
+}
+
+// Xorshift64* random numbers (the magic numbers are searched from fixed seeds, so every run builds the same tables)
+static uint64_t getRandomNumber(uint64_t& seed)
+{
+	seed ^= seed >> 12;
+	seed ^= seed << 25;
+	seed ^= seed >> 27;
+	return seed * 0x2545F4914F6CDD1DULL;
+}
+
+void AttackTables::initialize()
+{
+	// A function local static is initialized exactly once, even if several threads get here at the same time
+	static const bool built = []()
+	{
+		attackTables.build();
+		return true;
+	}();
+	(void)built;
+}
+
+void AttackTables::build()
+{
+	for (int square = 0; square < 64; square++)
+	{
+		pawnPushes[0][square] = BitboardGenerator::generatePawnPush(1ULL << square, 0);
+		pawnPushes[1][square] = BitboardGenerator::generatePawnPush(1ULL << square, 1);
+		pawnAttacks[0][square] = BitboardGenerator::generatePawnAttack(1ULL << square, 0);
+		pawnAttacks[1][square] = BitboardGenerator::generatePawnAttack(1ULL << square, 1);
+
+		knightMovement[square] = BitboardGenerator::generateKnightMoveset(1ULL << square);
+		kingMovement[square] = BitboardGenerator::generateKingMoveset(1ULL << square);
+
+		for (int secondSquare = 0; secondSquare < 64; secondSquare++)
+		{
+			squaresBetween[square][secondSquare] = BitboardGenerator::generateSquaresBetween(square, secondSquare);
+			lineThrough[square][secondSquare] = BitboardGenerator::generateLine(square, secondSquare);
+		}
+	}
+
+	buildSliderTables(bishopPext, buildSliderTables(rookPext, pextAttacks, true, false), false, false);
+	buildSliderTables(bishopMagic, buildSliderTables(rookMagic, magicAttacks, true, true), false, true);
+}
+
+uint64_t* AttackTables::buildSliderTables(SliderTable* tables, uint64_t* attacks, const bool rook, const bool magic)
+{
+	for (int square = 0; square < 64; square++)
+	{
+		const uint64_t mask = rook ? BitboardGenerator::generateRookOccupancyMask(1ULL << square) : BitboardGenerator::generateBishopOccupancyMask(1ULL << square);
+		const int bits = countBits(mask);
+
+		tables[square].attacks = attacks;
+		tables[square].mask = mask;
+		tables[square].magic = magic ? findMagicNumber(square, mask, bits, rook, MAGIC_SEEDS[square / 8]) : 0;
+		tables[square].shift = 64 - bits;
+
+		// Carry ripple subset enumeration. It visits the subsets in increasing order, which is the order of their PEXT indices, so the
+		// PEXT tables are filled with a counter (the tables are built on every CPU, also on those without BMI2)
+		uint64_t subset = 0;
+		uint64_t subsetNumber = 0;
+		do
+		{
+			const uint64_t index = magic ? (subset * tables[square].magic) >> tables[square].shift : subsetNumber;
+			attacks[index] = rook ? BitboardGenerator::generateRookMoveset(square, subset) : BitboardGenerator::generateBishopMoveset(square, subset);
+
+			subset = (subset - mask) & mask;
+			subsetNumber++;
+		} while (subset);
+
+		attacks += 1ULL << bits;
+	}
+
+	return attacks;
+}
+
+uint64_t AttackTables::findMagicNumber(const int square, const uint64_t mask, const int bits, const bool rook, uint64_t seed)
+{
+	const int size = 1 << bits;
+	std::vector<uint64_t> subsets, subsetAttacks;
+	subsets.reserve(size);
+	subsetAttacks.reserve(size);
+
+	uint64_t subset = 0;
+	do
+	{
+		subsets.push_back(subset);
+		subsetAttacks.push_back(rook ? BitboardGenerator::generateRookMoveset(square, subset) : BitboardGenerator::generateBishopMoveset(square, subset));
+		subset = (subset - mask) & mask;
+	} while (subset);
+
+	// The attacks stored at every index by the current candidate (an index belongs to the candidate if it was written on its attempt)
+	std::vector<uint64_t> usedAttacks(size);
+	std::vector<int> usedAttempt(size, 0);
+
+	for (int attempt = 1; ; attempt++)
+	{
+		// Sparse candidates are the most likely to work
+		const uint64_t magic = getRandomNumber(seed) & getRandomNumber(seed) & getRandomNumber(seed);
+
+		// The product has to spread the mask over the top bits
+		if (countBits((mask * magic) & 0xFF00000000000000ULL) < 6)
+			continue;
+
+		bool collision = false;
+		for (int i = 0; i < size && !collision; i++)
+		{
+			const uint64_t index = (subsets[i] * magic) >> (64 - bits);
+
+			if (usedAttempt[index] != attempt)
+			{
+				usedAttempt[index] = attempt;
+				usedAttacks[index] = subsetAttacks[i];
+			}
+			else if (usedAttacks[index] != subsetAttacks[i])
+				collision = true; // Two subsets with different attacks share an index
+		}
+
+		if (!collision)
+			return magic;
+	}
+}
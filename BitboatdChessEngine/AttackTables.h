@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+constexpr int ROOK_ATTACKS_SIZE = 102400; // The number of rook attack sets of all squares (every subset of every occupancy mask)
+constexpr int BISHOP_ATTACKS_SIZE = 5248; // The number of bishop attack sets of all squares
+
+// The movement tables of every square. They do not depend on the position, so they are built once per process into one cache line aligned
+// block that all engine instances and threads share (the small tables used at every node come first)
+struct alignas(64) AttackTables
+{
+	// The slider attacks of one square (indexed by PEXT or by the magic multiplication of the occupancy within the mask)
+	struct SliderTable
+	{
+		const uint64_t* attacks; // The attacks of every subset of the mask
+		uint64_t mask; // The squares whose occupancy changes the attacks (the board edges are left out)
+		uint64_t magic; // The magic number (unused by PEXT)
+		int shift; // The shift of the magic product (64 minus the number of bits in the mask)
+	};
+
+	SliderTable rookPext[64], bishopPext[64]; // The PEXT indexed slider tables
+	SliderTable rookMagic[64], bishopMagic[64]; // The magic indexed slider tables
+
+	uint64_t pawnPushes[2][64], pawnAttacks[2][64]; // Bitboards for pawn movement
+	uint64_t knightMovement[64]; // Bitboards for knight movement
+	uint64_t kingMovement[64]; // Bitboards for king movement
+
+	uint64_t squaresBetween[64][64]; // Bitboards containing the squares between two other squares (if they are on the same line or diagonal)
+	uint64_t lineThrough[64][64]; // Bitboards containing the whole line through two squares (if they are on the same line or diagonal)
+
+	uint64_t pextAttacks[ROOK_ATTACKS_SIZE + BISHOP_ATTACKS_SIZE]; // The attacks of the PEXT indexed slider tables
+	uint64_t magicAttacks[ROOK_ATTACKS_SIZE + BISHOP_ATTACKS_SIZE]; // The attacks of the magic indexed slider tables
+
+	static void initialize(); // Build the tables of the process (only the first call does any work, concurrent calls wait for it)
+
+	// Find a magic number mapping every subset of the mask to an index of the given number of bits without destructive collisions
+	static uint64_t findMagicNumber(const int square, const uint64_t mask, const int bits, const bool rook, uint64_t seed);
+
+private:
+	void build(); // Fill all the tables
+	uint64_t* buildSliderTables(SliderTable* tables, uint64_t* attacks, const bool rook, const bool magic); // Fill the slider tables of one piece type and index from the given attacks on (returns the end of the attacks filled)
+};
+
+extern AttackTables attackTables; // The tables shared by the whole process
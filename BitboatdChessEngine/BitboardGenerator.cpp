@@ -62,6 +62,25 @@ uint64_t BitboardGenerator::generateSquaresBetween(const int firstSquare, const
 	return 0ULL;
 }
 
+uint64_t BitboardGenerator::generateLine(const int firstSquare, const int secondSquare)
+{
+	// Check if the squares are equal
+	if (firstSquare == secondSquare)
+		return 0ULL;
+
+	uint64_t squares = (1ULL << firstSquare) | (1ULL << secondSquare);
+
+	// The rays of both squares on an empty board only share the line through them (the squares themselves are not on their own rays)
+	if (firstSquare / 8 == secondSquare / 8 || firstSquare % 8 == secondSquare % 8)
+		return (generateRookMoveset(firstSquare, 0ULL) & generateRookMoveset(secondSquare, 0ULL)) | squares;
+
+	if (generateBishopMoveset(firstSquare, 0ULL) & (1ULL << secondSquare))
+		return (generateBishopMoveset(firstSquare, 0ULL) & generateBishopMoveset(secondSquare, 0ULL)) | squares;
+
+	// Return no squares if the given squares are not on the same line or diagonal
+	return 0ULL;
+}
+
 uint64_t BitboardGenerator::generatePawnPush(const uint64_t pawnBitboard, const int color)
 {
 	if (color == 0)
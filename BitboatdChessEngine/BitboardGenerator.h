@@ -33,7 +33,12 @@ public:
 	static inline uint64_t southEast(const uint64_t square) { return (square >> 7) & ~FILE_A; } // Shift square 7 bits right (south-east), mask to avoid wrapping around the left edge
 	static inline uint64_t southWest(const uint64_t square) { return (square >> 9) & ~FILE_H; } // Shift square 9 bits right (south-west), mask to avoid wrapping around the right edge
 
+	static inline uint64_t northFill(uint64_t bitboard) { bitboard |= bitboard << 8; bitboard |= bitboard << 16; return bitboard | (bitboard << 32); } // Extend every set square to the north edge of the board
+	static inline uint64_t southFill(uint64_t bitboard) { bitboard |= bitboard >> 8; bitboard |= bitboard >> 16; return bitboard | (bitboard >> 32); } // Extend every set square to the south edge of the board
+
 	static uint64_t generateSquaresBetween(const int firstSquare, const int secondSquare);
+	// Generate a bitboard containing the whole line (rank, file, diagonal or anti-diagonal) through the given squares (empty if they are not on one line)
+	static uint64_t generateLine(const int firstSquare, const int secondSquare);
 
 	// Generate a bitboard containing the square the pawn on the given square and color (white = 0, black = 1) can push to
 	static uint64_t generatePawnPush(const uint64_t pawnBitboard, const int color);
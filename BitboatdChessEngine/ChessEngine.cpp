@@ -1,27 +1,138 @@
 #include "ChessEngine.h"
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 ChessEngine::ChessEngine() {
+    this->activePlayer = Color::WHITE;
+
+    // The movement tables are built by the first engine of the process and shared by all the others
+    AttackTables::initialize();
+    this->sliderAttacks.setBackend(SliderAttacks::getBest());
+
     initializeBitboards();
     initializeSquarePieceTypeArray();
     initializePromotionPieceToPieceTypeArray();
     initializePositionSpecialStatistics();
+    initializePieceSquareValues();
     initializeZobristHash();
+
+    this->numaNode = -1;
+    this->historyTable = nullptr;
+    this->killerMoves = nullptr;
+    allocateMoveOrderingTables(this->numaNode);
     initializeMoveOrderingTables();
     initializeTimeLimits();
 
-    this->transpositionTable = new TranspositionTableEntry[this->transpositionTableSize];
-    this->activePlayer = Color::WHITE;
+    allocateTranspositionTable();
+    this->shallowTranspositionTable = new TranspositionTableEntry[this->shallowTranspositionTableSize];
+    this->useShallowTranspositionTable = true;
+    this->pawnHashTable = new PawnHashTableEntry[this->pawnHashTableSize];
+    this->evaluationCache = new EvaluationCacheEntry[this->evaluationCacheSize]();
+    this->materialHashTable = new MaterialHashTableEntry[this->materialHashTableSize];
+    // The accumulators are read with aligned vector loads, and new only guarantees their alignment from C++17 on
+    this->accumulatorStack = static_cast<Accumulator*>(_mm_malloc(this->accumulatorStackSize * sizeof(Accumulator), 64));
+    this->accumulatorUpdates = new AccumulatorUpdate[this->accumulatorStackSize];
+    clearAccumulatorStack();
+    this->attackInfoStack = new AttackInfo[this->attackInfoStackSize];
+    clearAttackInfoStack();
+
+    // A network built into the binary is used from the start
+    if (NNUE::hasEmbeddedNetwork())
+        this->network.load(NNUE_EMBEDDED_NETWORK);
+
+    this->depthReached = 0;
+    this->timeUsedInMilliseconds = 0;
+
+    this->previousPositionsSize = 0;
+    this->previousPositions = new uint64_t[18000];
+
+    this->perftHashTable = nullptr;
+    this->perftHashTableSize = 0;
+}
+
+ChessEngine::ChessEngine(const ChessEngine& other)
+{
+    // The copy only makes and generates moves, so the search and evaluation tables are left out
+    this->sliderAttacks.setBackend(other.sliderAttacks.getBackend());
+
+    this->activePlayer = other.activePlayer;
+    this->halfmoveClock = other.halfmoveClock;
+    this->fullmoveCounter = other.fullmoveCounter;
+    std::memcpy(this->squarePieceType, other.squarePieceType, sizeof(this->squarePieceType));
+    std::memcpy(this->pieces, other.pieces, sizeof(this->pieces));
+    std::memcpy(this->allPieces, other.allPieces, sizeof(this->allPieces));
+
+    this->castlingRights = other.castlingRights;
+    this->whiteCastleQueenSide = other.whiteCastleQueenSide;
+    this->whiteCastleKingSide = other.whiteCastleKingSide;
+    this->blackCastleQueenSide = other.blackCastleQueenSide;
+    this->blackCastleKingSide = other.blackCastleKingSide;
+    std::memcpy(this->castlingRightsKept, other.castlingRightsKept, sizeof(this->castlingRightsKept));
+    this->enPassantTargetBitboard = other.enPassantTargetBitboard;
+    std::memcpy(this->promotionPieceToPieceType, other.promotionPieceToPieceType, sizeof(this->promotionPieceToPieceType));
+
+    std::memcpy(this->pieceZobristHash, other.pieceZobristHash, sizeof(this->pieceZobristHash));
+    std::memcpy(this->castlingRightsZobristHash, other.castlingRightsZobristHash, sizeof(this->castlingRightsZobristHash));
+    std::memcpy(this->enPassantTargetSquareZobristHash, other.enPassantTargetSquareZobristHash, sizeof(this->enPassantTargetSquareZobristHash));
+    this->changePlayerZobristHash = other.changePlayerZobristHash;
+    this->boardZobristHash = other.boardZobristHash;
+    std::memcpy(this->pieceSquareValue, other.pieceSquareValue, sizeof(this->pieceSquareValue));
+    this->pieceSquareScore = other.pieceSquareScore;
+    this->gamePhase = other.gamePhase;
+    this->pawnZobristHash = other.pawnZobristHash;
+    std::memcpy(this->pieceCountZobristHash, other.pieceCountZobristHash, sizeof(this->pieceCountZobristHash));
+    this->materialZobristHash = other.materialZobristHash;
+    initializeTimeLimits();
+
+    this->numaNode = -1;
+    this->historyTable = nullptr;
+    this->killerMoves = nullptr;
+    this->transpositionTable = nullptr;
+    this->transpositionTableStorage = TranspositionTableStorage::PRIVATE_MEMORY;
+    this->transpositionTableFileMapping = nullptr;
+    this->transpositionTableFileMappingSize = 0;
+    this->shallowTranspositionTable = nullptr;
+    this->useShallowTranspositionTable = true;
+    this->pawnHashTable = nullptr;
+    this->evaluationCache = nullptr;
+    this->materialHashTable = nullptr;
+
+    this->accumulatorStack = static_cast<Accumulator*>(_mm_malloc(this->accumulatorStackSize * sizeof(Accumulator), 64));
+    this->accumulatorUpdates = new AccumulatorUpdate[this->accumulatorStackSize];
+    clearAccumulatorStack();
+    this->attackInfoStack = new AttackInfo[this->attackInfoStackSize];
+    clearAttackInfoStack();
+
+    this->depthReached = 0;
+    this->timeUsedInMilliseconds = 0;
 
     this->previousPositionsSize = 0;
     this->previousPositions = new uint64_t[18000];
+
+    this->perftHashTable = nullptr;
+    this->perftHashTableSize = 0;
 }
 
 ChessEngine::~ChessEngine()
 {
-    delete[] transpositionTable;
-    delete[] rookMovement;
-    delete[] bishopMovement;
+    freeTranspositionTable();
+    delete[] shallowTranspositionTable;
+    delete[] pawnHashTable;
+    delete[] evaluationCache;
+    delete[] materialHashTable;
+    _mm_free(accumulatorStack);
+    delete[] accumulatorUpdates;
+    delete[] attackInfoStack;
+    freeMoveOrderingTables();
     delete[] previousPositions;
 }
 
@@ -235,18 +346,17 @@ void ChessEngine::loadFENPosition(const std::string position)
     initializeSquarePieceTypeArray();
 
     // Change the zobrist hash
-    this->boardZobristHash = 0ULL;
-
-    // Add pieces
-    for (int square = 0; square < 64; square++)
-        this->boardZobristHash ^= this->pieceZobristHash[squarePieceType[square]][square];
+    this->boardZobristHash = computeZobristHash();
+    this->pawnZobristHash = computePawnZobristHash();
+    this->materialZobristHash = computeMaterialZobristHash();
 
-    // Add castling rights
-    this->boardZobristHash ^= this->castlingRightsZobristHash[this->castlingRights];
+    // Recompute the material and positional score and the game phase
+    this->pieceSquareScore = computePieceSquareScore();
+    this->gamePhase = computeGamePhase();
 
-    // Add en passant square
-    if (this->enPassantTargetBitboard)
-        this->boardZobristHash ^= this->enPassantTargetSquareZobristHash[_tzcnt_u64(this->enPassantTargetBitboard)];
+    // The network accumulator is refreshed from the new board when it is needed
+    clearAccumulatorStack();
+    clearAttackInfoStack();
 }
 
 uint64_t ChessEngine::getAllPieces() const
@@ -299,6 +409,16 @@ void ChessEngine::initializePositionSpecialStatistics()
     blackCastleQueenSide = 1 << 2;
     blackCastleKingSide = 1 << 3;
 
+    // Moving a piece from or to the squares of the kings and rooks loses their castling rights
+    for (int square = 0; square < 64; square++)
+        castlingRightsKept[square] = 0xF;
+    castlingRightsKept[0] &= ~whiteCastleQueenSide;
+    castlingRightsKept[7] &= ~whiteCastleKingSide;
+    castlingRightsKept[4] &= ~(whiteCastleQueenSide | whiteCastleKingSide);
+    castlingRightsKept[56] &= ~blackCastleQueenSide;
+    castlingRightsKept[63] &= ~blackCastleKingSide;
+    castlingRightsKept[60] &= ~(blackCastleQueenSide | blackCastleKingSide);
+
     // Initialize en passant target squares
     enPassantTargetBitboard = 0ULL;
 
@@ -309,37 +429,143 @@ void ChessEngine::initializePositionSpecialStatistics()
 
 void ChessEngine::initializeZobristHash()
 {
-    std::random_device randomDevice;
-    std::mt19937_64 generator(randomDevice());
-    std::uniform_int_distribution<uint64_t> distribution(0, UINT64_MAX);
+    // Use a fixed seed, so every engine process produces the same hashes (the raw generator output is fully specified by the standard)
+    std::mt19937_64 generator(ZOBRIST_SEED);
 
     // Piece zobrist hashes
-    for (int type = 0; type < 6; type++)
-        for (int square = 0; square < 64; square++)
-            this->pieceZobristHash[type][square] = distribution(generator);
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+            for (int square = 0; square < 64; square++)
+                this->pieceZobristHash[color][type][square] = generator();
 
     // Castling rights zobrist hashes
     for (int i = 0; i < 16; i++)
-        this->castlingRightsZobristHash[i] = distribution(generator);
+        this->castlingRightsZobristHash[i] = generator();
 
     // En passant zobrist hashes
     for (int square = 0; square < 64; square++)
-        this->enPassantTargetSquareZobristHash[square] = distribution(generator);
+        this->enPassantTargetSquareZobristHash[square] = generator();
+
+    // Active player zobrist hash
+    this->changePlayerZobristHash = generator();
 
+    // Piece count zobrist hashes (generated last, so the other hashes stay the same)
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+            for (int count = 0; count < 64; count++)
+                this->pieceCountZobristHash[color][type][count] = generator();
 
     // Total board zobrist hash
-    this->boardZobristHash = 0ULL;
-    
+    this->boardZobristHash = computeZobristHash();
+    this->pawnZobristHash = computePawnZobristHash();
+    this->materialZobristHash = computeMaterialZobristHash();
+    this->pieceSquareScore = computePieceSquareScore();
+    this->gamePhase = computeGamePhase();
+}
+
+void ChessEngine::initializePieceSquareValues()
+{
+    // The value tables are written from white's side, black uses them with the board turned around
+    for (int type = 0; type < 6; type++)
+        for (int square = 0; square < 64; square++)
+        {
+            // Kings have their own end game table (index 6)
+            const int endgameTable = type == KING ? 6 : type;
+            this->pieceSquareValue[WHITE][type][square] = makeScore(pieceValue[type] + positionValue[type][square], pieceValue[type] + positionValue[endgameTable][square]);
+            this->pieceSquareValue[BLACK][type][square] = -makeScore(pieceValue[type] + positionValue[type][63 - square], pieceValue[type] + positionValue[endgameTable][63 - square]);
+        }
+}
+
+int ChessEngine::computePieceSquareScore() const
+{
+    int score = 0;
+
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+        {
+            uint64_t bitboard = pieces[color][type];
+
+            while (bitboard)
+            {
+                score += this->pieceSquareValue[color][type][_tzcnt_u64(bitboard)];
+                bitboard &= bitboard - 1;
+            }
+        }
+
+    return score;
+}
+
+int ChessEngine::computeGamePhase() const
+{
+    int phase = 0;
+
+    for (int color = 0; color < 2; color++)
+        for (int type = KNIGHT; type <= QUEEN; type++)
+            phase += static_cast<int>(_mm_popcnt_u64(pieces[color][type])) * PIECE_PHASE[type];
+
+    return phase;
+}
+
+uint64_t ChessEngine::computeZobristHash() const
+{
+    uint64_t zobristHash = 0ULL;
+
     // Add pieces
-    for (int square = 0; square < 64; square++)
-        this->boardZobristHash ^= this->pieceZobristHash[squarePieceType[square]][square];
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+        {
+            uint64_t bitboard = pieces[color][type];
+
+            while (bitboard)
+            {
+                zobristHash ^= this->pieceZobristHash[color][type][_tzcnt_u64(bitboard)];
+                bitboard &= bitboard - 1;
+            }
+        }
 
     // Add castling rights
-    this->boardZobristHash ^= this->castlingRightsZobristHash[this->castlingRights];
+    zobristHash ^= this->castlingRightsZobristHash[this->castlingRights & 0xF];
 
     // Add en passant square
     if (this->enPassantTargetBitboard)
-        this->boardZobristHash ^= this->enPassantTargetSquareZobristHash[_tzcnt_u64(this->enPassantTargetBitboard)];
+        zobristHash ^= this->enPassantTargetSquareZobristHash[_tzcnt_u64(this->enPassantTargetBitboard)];
+
+    // Add the active player (the hash is changed every time black gets to move)
+    if (this->activePlayer == Color::BLACK)
+        zobristHash ^= this->changePlayerZobristHash;
+
+    return zobristHash;
+}
+
+uint64_t ChessEngine::computePawnZobristHash() const
+{
+    uint64_t zobristHash = 0ULL;
+
+    for (int color = 0; color < 2; color++)
+    {
+        uint64_t bitboard = pieces[color][PAWN];
+
+        while (bitboard)
+        {
+            zobristHash ^= this->pieceZobristHash[color][PAWN][_tzcnt_u64(bitboard)];
+            bitboard &= bitboard - 1;
+        }
+    }
+
+    return zobristHash;
+}
+
+uint64_t ChessEngine::computeMaterialZobristHash() const
+{
+    uint64_t zobristHash = 0ULL;
+
+    // Kings are always on the board and do not take part in the material signature
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 5; type++)
+            for (int count = 0; count < _mm_popcnt_u64(pieces[color][type]); count++)
+                zobristHash ^= this->pieceCountZobristHash[color][type][count];
+
+    return zobristHash;
 }
 
 void ChessEngine::initializeMoveOrderingTables()
@@ -351,11 +577,77 @@ void ChessEngine::initializeMoveOrderingTables()
                 this->historyTable[color][from][to] = 0;
 }
 
-void ChessEngine::initializeSquaresBetweenBitboards()
+void ChessEngine::allocateTranspositionTable()
+{
+    // Interleave the transposition table pages across NUMA nodes on Linux (the zeroed memory holds empty entries)
+    this->transpositionTable = static_cast<TranspositionTableEntry*>(SystemHelper::allocateInterleaved(this->transpositionTableSize * sizeof(TranspositionTableEntry)));
+    this->transpositionTableStorage = TranspositionTableStorage::PRIVATE_MEMORY;
+    this->transpositionTableName = "";
+    this->transpositionTableFileMapping = nullptr;
+    this->transpositionTableFileMappingSize = 0;
+    this->transpositionTableFilePath = "";
+}
+
+void ChessEngine::freeTranspositionTable()
+{
+    switch (this->transpositionTableStorage)
+    {
+    case TranspositionTableStorage::PRIVATE_MEMORY:
+        SystemHelper::freeLargeMemory(this->transpositionTable, this->transpositionTableSize * sizeof(TranspositionTableEntry));
+        break;
+    case TranspositionTableStorage::SHARED_MEMORY:
+        SystemHelper::detachSharedMemory(this->transpositionTable, this->transpositionTableSize * sizeof(TranspositionTableEntry));
+        break;
+    case TranspositionTableStorage::MAPPED_FILE:
+        SystemHelper::unmapFile(this->transpositionTableFileMapping, this->transpositionTableFileMappingSize);
+        break;
+    }
+
+    this->transpositionTable = nullptr;
+    this->transpositionTableName = "";
+    this->transpositionTableFileMapping = nullptr;
+    this->transpositionTableFileMappingSize = 0;
+    this->transpositionTableFilePath = "";
+}
+
+uint64_t ChessEngine::getZobristSignature() const
+{
+    // Mix keys from every part of the zobrist tables, so any change in how they are generated changes the signature
+    return ZOBRIST_SEED ^ this->pieceZobristHash[WHITE][PAWN][8] ^ (this->pieceZobristHash[BLACK][KING][60] << 1) ^
+        (this->castlingRightsZobristHash[15] << 2) ^ (this->enPassantTargetSquareZobristHash[40] << 3) ^ (this->changePlayerZobristHash << 4);
+}
+
+uint64_t ChessEngine::getEvaluationSignature() const
+{
+    // The network is told apart by its parameters, the handcrafted evaluation by its version
+    return this->network.isLoaded() ? this->network.getSignature() : HANDCRAFTED_EVALUATION_VERSION;
+}
+
+void ChessEngine::allocateMoveOrderingTables(const int node)
+{
+    // Allocate the new tables (on the given node if there is one, otherwise where the search thread first touches them)
+    int (*newHistoryTable)[64][64] = static_cast<int(*)[64][64]>(node >= 0 ? SystemHelper::allocateOnNumaNode(sizeof(int) * 2 * 64 * 64, node) : SystemHelper::allocateLargeMemory(sizeof(int) * 2 * 64 * 64));
+    Move (*newKillerMoves)[2] = static_cast<Move(*)[2]>(node >= 0 ? SystemHelper::allocateOnNumaNode(sizeof(Move) * (MAX_DEPTH + 1) * 2, node) : SystemHelper::allocateLargeMemory(sizeof(Move) * (MAX_DEPTH + 1) * 2));
+
+    // Keep the contents of the old tables
+    if (this->historyTable != nullptr)
+        memcpy(newHistoryTable, this->historyTable, sizeof(int) * 2 * 64 * 64);
+    if (this->killerMoves != nullptr)
+        memcpy(newKillerMoves, this->killerMoves, sizeof(Move) * (MAX_DEPTH + 1) * 2);
+
+    freeMoveOrderingTables();
+
+    this->historyTable = newHistoryTable;
+    this->killerMoves = newKillerMoves;
+}
+
+void ChessEngine::freeMoveOrderingTables()
 {
-    for (int firstSquare = 0; firstSquare < 64; firstSquare++)
-        for (int secondSquare = 0; secondSquare < 64; secondSquare++)
-            squaresBetween[firstSquare][secondSquare] = BitboardGenerator::generateSquaresBetween(firstSquare, secondSquare);
+    SystemHelper::freeLargeMemory(this->historyTable, sizeof(int) * 2 * 64 * 64);
+    SystemHelper::freeLargeMemory(this->killerMoves, sizeof(Move) * (MAX_DEPTH + 1) * 2);
+
+    this->historyTable = nullptr;
+    this->killerMoves = nullptr;
 }
 
 void ChessEngine::decayHistoryTable()
@@ -393,7 +685,290 @@ void ChessEngine::updateKillerMoves(const Move move, const int ply)
 
 void ChessEngine::clearKillerMoves()
 {
-    memset(this->killerMoves, 0, sizeof(killerMoves));
+    memset(this->killerMoves, 0, sizeof(Move) * (MAX_DEPTH + 1) * 2);
+}
+
+const ChessEngine::AttackInfo& ChessEngine::getAttackInfo() const
+{
+    AttackInfo& info = this->attackInfoStack[this->attackInfoPly & (this->attackInfoStackSize - 1)];
+
+    // The entry may still hold the attack info of a sibling or of a position deeper in the tree
+    if (info.ply != this->attackInfoPly)
+    {
+        computeCheckersAndPins(info);
+        info.ply = this->attackInfoPly;
+        info.attackMapsPly = INT_MIN;
+        info.checkSquaresPly = INT_MIN;
+        info.xrayAttackersComputed = 0ULL;
+    }
+
+    return info;
+}
+
+const ChessEngine::AttackInfo& ChessEngine::getAttackMaps() const
+{
+    getAttackInfo();
+
+    // The attack maps cost a lookup for every piece, so they are only computed for the positions that use them
+    AttackInfo& info = this->attackInfoStack[this->attackInfoPly & (this->attackInfoStackSize - 1)];
+    if (info.attackMapsPly != this->attackInfoPly)
+    {
+        computeAttackMaps(info);
+        info.attackMapsPly = this->attackInfoPly;
+    }
+
+    return info;
+}
+
+const ChessEngine::AttackInfo& ChessEngine::getCheckSquares() const
+{
+    getAttackInfo();
+
+    AttackInfo& info = this->attackInfoStack[this->attackInfoPly & (this->attackInfoStackSize - 1)];
+    if (info.checkSquaresPly != this->attackInfoPly)
+    {
+        computeCheckSquares(info);
+        info.checkSquaresPly = this->attackInfoPly;
+    }
+
+    return info;
+}
+
+void ChessEngine::computeCheckersAndPins(AttackInfo& info) const
+{
+    const Color color = this->activePlayer;
+    const Color enemyColor = static_cast<Color>(color ^ 1);
+    const uint64_t allPiecesOnBoard = allPieces[WHITE] | allPieces[BLACK];
+    const uint64_t enemyPieces = allPieces[enemyColor];
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    const uint64_t enemyRooks = pieces[enemyColor][ROOK] | pieces[enemyColor][QUEEN];
+    const uint64_t enemyBishops = pieces[enemyColor][BISHOP] | pieces[enemyColor][QUEEN];
+
+    info.checkers = (attackTables.pawnAttacks[color][kingSquare] & pieces[enemyColor][PAWN]) | (attackTables.knightMovement[kingSquare] & pieces[enemyColor][KNIGHT]);
+    info.pinned = 0ULL;
+
+    // Enemy sliders that see the king through the pieces of the side to move give check or pin the only piece in between
+    uint64_t sliders = (sliderAttacks.getRookAttacks(kingSquare, enemyPieces) & enemyRooks) |
+        (sliderAttacks.getBishopAttacks(kingSquare, enemyPieces) & enemyBishops);
+    while (sliders)
+    {
+        int sliderSquare = _tzcnt_u64(sliders);
+        uint64_t piecesBetween = attackTables.squaresBetween[kingSquare][sliderSquare] & allPiecesOnBoard;
+
+        if (!piecesBetween)
+            info.checkers |= 1ULL << sliderSquare;
+        else if (!(piecesBetween & (piecesBetween - 1)))
+            info.pinned |= piecesBetween;
+
+        sliders &= sliders - 1;
+    }
+}
+
+void ChessEngine::computeAttackMaps(AttackInfo& info) const
+{
+    const Color enemyColor = static_cast<Color>(this->activePlayer ^ 1);
+    const uint64_t allPiecesOnBoard = allPieces[WHITE] | allPieces[BLACK];
+
+    info.attackedSquares[WHITE] = 0ULL;
+    info.attackedSquares[BLACK] = 0ULL;
+
+    for (int side = WHITE; side <= BLACK; side++)
+    {
+        // The enemy sliders see through the king of the side to move, so the king can not step back along the line of a check
+        const uint64_t occupancy = side == enemyColor ? allPiecesOnBoard ^ pieces[this->activePlayer][KING] : allPiecesOnBoard;
+
+        for (int pieceType = PAWN; pieceType <= KING; pieceType++)
+        {
+            uint64_t bitboard = pieces[side][pieceType];
+            while (bitboard)
+            {
+                // Get the LSB
+                int square = _tzcnt_u64(bitboard);
+
+                uint64_t attacks = 0ULL;
+                switch (pieceType)
+                {
+                case PAWN:
+                    attacks = attackTables.pawnAttacks[side][square];
+                    break;
+                case KNIGHT:
+                    attacks = attackTables.knightMovement[square];
+                    break;
+                case BISHOP:
+                    attacks = sliderAttacks.getBishopAttacks(square, occupancy);
+                    break;
+                case ROOK:
+                    attacks = sliderAttacks.getRookAttacks(square, occupancy);
+                    break;
+                case QUEEN:
+                    attacks = sliderAttacks.getBishopAttacks(square, occupancy) |
+                        sliderAttacks.getRookAttacks(square, occupancy);
+                    break;
+                case KING:
+                    attacks = attackTables.kingMovement[square];
+                    break;
+                }
+
+                info.pieceAttacks[square] = attacks;
+                info.attackedSquares[side] |= attacks;
+
+                // Remove the LSB
+                bitboard &= bitboard - 1;
+            }
+        }
+    }
+}
+
+void ChessEngine::computeCheckSquares(AttackInfo& info) const
+{
+    const Color color = this->activePlayer;
+    const Color enemyColor = static_cast<Color>(color ^ 1);
+    const uint64_t allPiecesOnBoard = allPieces[WHITE] | allPieces[BLACK];
+    const int enemyKingSquare = _tzcnt_u64(pieces[enemyColor][KING]);
+
+    // A piece gives check from the squares it would attack the enemy king from
+    info.checkSquares[PAWN] = attackTables.pawnAttacks[enemyColor][enemyKingSquare];
+    info.checkSquares[KNIGHT] = attackTables.knightMovement[enemyKingSquare];
+    info.checkSquares[BISHOP] = sliderAttacks.getBishopAttacks(enemyKingSquare, allPiecesOnBoard);
+    info.checkSquares[ROOK] = sliderAttacks.getRookAttacks(enemyKingSquare, allPiecesOnBoard);
+    info.checkSquares[QUEEN] = info.checkSquares[BISHOP] | info.checkSquares[ROOK];
+    info.checkSquares[KING] = 0ULL;
+    info.discoveredCheckers = 0ULL;
+
+    // Sliders of the side to move that see the enemy king through their own pieces give a discovered check when the only piece in between leaves the line
+    uint64_t sliders = (sliderAttacks.getRookAttacks(enemyKingSquare, allPieces[enemyColor]) & (pieces[color][ROOK] | pieces[color][QUEEN])) |
+        (sliderAttacks.getBishopAttacks(enemyKingSquare, allPieces[enemyColor]) & (pieces[color][BISHOP] | pieces[color][QUEEN]));
+    while (sliders)
+    {
+        uint64_t piecesBetween = attackTables.squaresBetween[enemyKingSquare][_tzcnt_u64(sliders)] & allPiecesOnBoard;
+
+        if (!(piecesBetween & (piecesBetween - 1)))
+            info.discoveredCheckers |= piecesBetween & allPieces[color];
+
+        sliders &= sliders - 1;
+    }
+}
+
+void ChessEngine::clearAttackInfoStack()
+{
+    for (int i = 0; i < this->attackInfoStackSize; i++)
+        this->attackInfoStack[i].ply = INT_MIN;
+    this->attackInfoPly = 0;
+}
+
+bool ChessEngine::isLegal(const Move move) const
+{
+    const AttackInfo& info = getAttackInfo();
+    const Color color = this->activePlayer;
+    const Color enemyColor = static_cast<Color>(color ^ 1);
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    const int fromSquare = move.from();
+    const int toSquare = move.to();
+    const uint64_t fromSquareMask = 1ULL << fromSquare;
+    const uint64_t toSquareMask = 1ULL << toSquare;
+
+    // The king can go to any square the enemy does not attack (castling is checked when it is generated)
+    if (fromSquare == kingSquare)
+    {
+        if (move.moveType() == Move::MoveType::CASTLE)
+            return true;
+        if (info.attackMapsPly == this->attackInfoPly)
+            return !(toSquareMask & info.attackedSquares[enemyColor]);
+
+        // The king does not block the line of a slider checking it
+        return !isAttacked(toSquare, enemyColor, (allPieces[WHITE] | allPieces[BLACK]) ^ fromSquareMask);
+    }
+
+    if (move.moveType() == Move::MoveType::EN_PASSANT)
+        return isLegalEnPassant(fromSquare, toSquare);
+
+    // In check, the other pieces have to capture the only checker or block it
+    if (info.checkers)
+    {
+        if (info.checkers & (info.checkers - 1))
+            return false;
+        if (!(toSquareMask & (info.checkers | attackTables.squaresBetween[kingSquare][_tzcnt_u64(info.checkers)])))
+            return false;
+    }
+
+    // A pinned piece can only move along the line through the king
+    if (fromSquareMask & info.pinned)
+        return (attackTables.squaresBetween[kingSquare][toSquare] & fromSquareMask) || (attackTables.squaresBetween[kingSquare][fromSquare] & toSquareMask);
+
+    return true;
+}
+
+bool ChessEngine::isLegalEnPassant(const int fromSquare, const int toSquare) const
+{
+    const Color color = this->activePlayer;
+    const uint64_t toSquareMask = 1ULL << toSquare;
+
+    // En passant removes two pieces from a line, so the king is checked on the board after the capture
+    const uint64_t capturedPawn = color == Color::WHITE ? toSquareMask >> 8 : toSquareMask << 8;
+    const uint64_t occupancy = ((allPieces[WHITE] | allPieces[BLACK]) ^ (1ULL << fromSquare) ^ capturedPawn) | toSquareMask;
+
+    return !isAttacked(_tzcnt_u64(pieces[color][KING]), static_cast<Color>(color ^ 1), occupancy);
+}
+
+bool ChessEngine::givesCheck(const Move move) const
+{
+    const AttackInfo& info = getCheckSquares();
+    const Color color = this->activePlayer;
+    const Color enemyColor = static_cast<Color>(color ^ 1);
+    const uint64_t enemyKing = pieces[enemyColor][KING];
+    const int enemyKingSquare = _tzcnt_u64(enemyKing);
+    const int fromSquare = move.from();
+    const int toSquare = move.to();
+    const uint64_t fromSquareMask = 1ULL << fromSquare;
+    const uint64_t toSquareMask = 1ULL << toSquare;
+    const uint64_t allPiecesOnBoard = allPieces[WHITE] | allPieces[BLACK];
+
+    // Direct check (the piece can not be on the line from the target square to the king already, it would be giving check)
+    if (move.moveType() != Move::MoveType::PROMOTION && (info.checkSquares[squarePieceType[fromSquare]] & toSquareMask))
+        return true;
+
+    // Discovered check (a piece moving along the line keeps blocking it)
+    if ((info.discoveredCheckers & fromSquareMask) && !(attackTables.lineThrough[enemyKingSquare][fromSquare] & toSquareMask))
+        return true;
+
+    switch (move.moveType())
+    {
+    case Move::MoveType::PROMOTION:
+    {
+        // The square the pawn leaves can open a line for the new piece
+        const uint64_t occupancy = allPiecesOnBoard ^ fromSquareMask;
+        switch (promotionPieceToPieceType[move.promotionPiece()])
+        {
+        case KNIGHT:
+            return attackTables.knightMovement[toSquare] & enemyKing;
+        case BISHOP:
+            return sliderAttacks.getBishopAttacks(toSquare, occupancy) & enemyKing;
+        case ROOK:
+            return sliderAttacks.getRookAttacks(toSquare, occupancy) & enemyKing;
+        default:
+            return (sliderAttacks.getBishopAttacks(toSquare, occupancy) | sliderAttacks.getRookAttacks(toSquare, occupancy)) & enemyKing;
+        }
+    }
+    case Move::MoveType::EN_PASSANT:
+    {
+        // Removing the captured pawn can open a line to the king as well
+        const int capturedSquare = color == Color::WHITE ? toSquare - 8 : toSquare + 8;
+        const uint64_t occupancy = allPiecesOnBoard ^ fromSquareMask ^ toSquareMask ^ (1ULL << capturedSquare);
+        return (sliderAttacks.getRookAttacks(enemyKingSquare, occupancy) & (pieces[color][ROOK] | pieces[color][QUEEN])) ||
+            (sliderAttacks.getBishopAttacks(enemyKingSquare, occupancy) & (pieces[color][BISHOP] | pieces[color][QUEEN]));
+    }
+    case Move::MoveType::CASTLE:
+    {
+        // The rook jumps over the king to the square next to it
+        const bool kingSide = toSquare > fromSquare;
+        const int rookFromSquare = kingSide ? fromSquare + 3 : fromSquare - 4;
+        const int rookToSquare = kingSide ? fromSquare + 1 : fromSquare - 1;
+        const uint64_t occupancy = allPiecesOnBoard ^ fromSquareMask ^ toSquareMask ^ (1ULL << rookFromSquare) ^ (1ULL << rookToSquare);
+        return sliderAttacks.getRookAttacks(rookToSquare, occupancy) & enemyKing;
+    }
+    default:
+        return false;
+    }
 }
 
 uint64_t ChessEngine::getXrayAttacksToSquare(const int square, const Color color) const
@@ -401,19 +976,19 @@ uint64_t ChessEngine::getXrayAttacksToSquare(const int square, const Color color
     uint64_t allAttacks = 0ULL;
 
     // Check for pawn attacks
-    allAttacks |= pieces[color][PAWN] & pawnAttacks[color ^ 1][square];
+    allAttacks |= pieces[color][PAWN] & attackTables.pawnAttacks[color ^ 1][square];
 
     // Check for knight attacks
-    allAttacks |= pieces[color][KNIGHT] & knightMovement[square];
+    allAttacks |= pieces[color][KNIGHT] & attackTables.knightMovement[square];
     
     uint64_t allPiecesOnBoard = allPieces[WHITE] | allPieces[BLACK];
 
     // Check for bishop attacks
-    uint64_t possibleBishopMoves = bishopMovement[bishopSquareOffset[square] + _pext_u64(allPiecesOnBoard & ~pieces[color][BISHOP] & ~pieces[color][QUEEN] & bishopOccupancyMask[square], bishopOccupancyMask[square])];
+    uint64_t possibleBishopMoves = sliderAttacks.getBishopAttacks(square, allPiecesOnBoard & ~pieces[color][BISHOP] & ~pieces[color][QUEEN]);
     allAttacks |= pieces[color][BISHOP] & possibleBishopMoves;
 
     // Check for rook attacks
-    uint64_t possibleRookMoves = rookMovement[rookSquareOffset[square] + _pext_u64(allPiecesOnBoard & ~pieces[color][ROOK] & ~pieces[color][QUEEN] & rookOccupancyMask[square], rookOccupancyMask[square])];
+    uint64_t possibleRookMoves = sliderAttacks.getRookAttacks(square, allPiecesOnBoard & ~pieces[color][ROOK] & ~pieces[color][QUEEN]);
     allAttacks |= pieces[color][ROOK] & possibleRookMoves;
     
 
@@ -421,11 +996,25 @@ uint64_t ChessEngine::getXrayAttacksToSquare(const int square, const Color color
     allAttacks |= pieces[color][QUEEN] & (possibleRookMoves | possibleBishopMoves);
 
     // Check for king attacks
-    allAttacks |= pieces[color][KING] & kingMovement[square];
+    allAttacks |= pieces[color][KING] & attackTables.kingMovement[square];
 
     return allAttacks;
 }
 
+uint64_t ChessEngine::getXrayAttackers(const int square) const
+{
+    // The attackers of a square are computed once per position, however many captures on it are ordered
+    getAttackInfo();
+    AttackInfo& info = this->attackInfoStack[this->attackInfoPly & (this->attackInfoStackSize - 1)];
+    if (!(info.xrayAttackersComputed & (1ULL << square)))
+    {
+        info.xrayAttackers[square] = this->getXrayAttacksToSquare(square, WHITE) | this->getXrayAttacksToSquare(square, BLACK);
+        info.xrayAttackersComputed |= 1ULL << square;
+    }
+
+    return info.xrayAttackers[square];
+}
+
 int ChessEngine::SEE(const int square, const Color color) const
 {
     int gains[MAX_SEE_DEPTH] = { 0 };
@@ -436,8 +1025,9 @@ int ChessEngine::SEE(const int square, const Color color) const
     uint64_t attackers[2];
     int side = color;
 
-    attackers[color] = this->getXrayAttacksToSquare(square, color);
-    attackers[color ^ 1] = this->getXrayAttacksToSquare(square, static_cast<Color>(color ^ 1));
+    const uint64_t allAttackers = this->getXrayAttackers(square);
+    attackers[color] = allAttackers & allPieces[color];
+    attackers[color ^ 1] = allAttackers & allPieces[color ^ 1];
 
     while (depth < MAX_SEE_DEPTH && attackers[side])
     {
@@ -474,126 +1064,36 @@ void ChessEngine::initializeBitboards() {
 
     allPieces[WHITE] = 0x000000000000FFFFULL;
     allPieces[BLACK] = 0xFFFF000000000000ULL;
-
-    initializeSquaresBetweenBitboards();
-
-    initializePawnMovesetBitboards();
-    initializeKnightMovesetBitboards();
-    initializeKingMovesetBitboards();
-    
-    initializeRookOccupancyMasks();
-    initializeRookMovesetBitboards();
-
-    initializeBishopOccupancyMasks();
-    initializeBishopMovesetBitboards();
-}
-
-void ChessEngine::initializePawnMovesetBitboards()
-{
-    for (int square = 0; square < 64; square++)
-    {
-        // Generate pushes
-        pawnPushes[WHITE][square] = BitboardGenerator::generatePawnPush(1ULL << square, WHITE);
-        pawnPushes[BLACK][square] = BitboardGenerator::generatePawnPush(1ULL << square, BLACK);
-
-        // Generate attacks
-        pawnAttacks[WHITE][square] = BitboardGenerator::generatePawnAttack(1ULL << square, WHITE);
-        pawnAttacks[BLACK][square] = BitboardGenerator::generatePawnAttack(1ULL << square, BLACK);
-    }
-}
-
-void ChessEngine::initializeKnightMovesetBitboards()
-{
-    for (int square = 0; square < 64; square++)
-        knightMovement[square] = BitboardGenerator::generateKnightMoveset(1ULL << square);
-}
-
-void ChessEngine::initializeKingMovesetBitboards()
-{
-    for (int square = 0; square < 64; square++)
-        kingMovement[square] = BitboardGenerator::generateKingMoveset(1ULL << square);
 }
 
-void ChessEngine::initializeRookOccupancyMasks()
+template <ChessEngine::Color color>
+void ChessEngine::addPawnMoves(MoveList& moveList, const uint64_t checkMask) const
 {
-    for (int square = 0; square < 64; square++)
-        rookOccupancyMask[square] = BitboardGenerator::generateRookOccupancyMask(1ULL << square);
-}
-
-void ChessEngine::initializeRookMovesetBitboards()
-{
-    this->rookMovement = new uint64_t[102400];
-    int rookMovementIndex = 0;
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const AttackInfo& info = getAttackInfo();
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    uint64_t pawns = pieces[color][PAWN];
+    uint64_t allPiecesOnBoard = allPieces[color] | allPieces[enemyColor];
+    constexpr uint64_t doublePushRank = color == Color::WHITE ? BitboardGenerator::RANK_2 : BitboardGenerator::RANK_7;
+    constexpr uint64_t promotionRank = color == Color::WHITE ? BitboardGenerator::RANK_7 : BitboardGenerator::RANK_2;
 
-    for (int square = 0; square < 64; square++)
+    while (pawns)
     {
-        rookSquareOffset[square] = rookMovementIndex;
+        // Get the LSB
+        int square = _tzcnt_u64(pawns);
 
-        uint64_t occupancyMask = BitboardGenerator::generateRookOccupancyMask(1ULL << square);
-        uint64_t subset = 0;
+        // Bitboard containing the currently processed pawn
+        uint64_t singlePawnBitboard = 1ULL << square;
 
-        // Carry ripple subset enumeration
-        do
+        // A pinned pawn can only move along the line through the king
+        uint64_t mask = (singlePawnBitboard & info.pinned) ? checkMask & attackTables.lineThrough[kingSquare][square] : checkMask;
+
+        // Add pawn pushes
+        if (!(attackTables.pawnPushes[color][square] & allPiecesOnBoard))
         {
-            // PEXT operation for hashing occupancy set
-            rookMovement[rookSquareOffset[square] + _pext_u64(subset, occupancyMask)] = BitboardGenerator::generateRookMoveset(square, subset);
-            rookMovementIndex++;
-            
-            subset = (subset - occupancyMask) & occupancyMask;
-        } while (subset);
-    }
-}
+            int pushSquare = _tzcnt_u64(attackTables.pawnPushes[color][square]);
 
-void ChessEngine::initializeBishopOccupancyMasks()
-{
-    for (int square = 0; square < 64; square++)
-        bishopOccupancyMask[square] = BitboardGenerator::generateBishopOccupancyMask(1ULL << square);
-}
-
-void ChessEngine::initializeBishopMovesetBitboards()
-{
-    this->bishopMovement = new uint64_t[5248];
-    int bishopMovementIndex = 0;
-
-    for (int square = 0; square < 64; square++)
-    {
-        bishopSquareOffset[square] = bishopMovementIndex;
-
-        uint64_t occupancyMask = BitboardGenerator::generateBishopOccupancyMask(1ULL << square);
-        uint64_t subset = 0;
-        
-        do
-        {
-            // PEXT operation for hashing occupancy set
-            bishopMovement[bishopSquareOffset[square] + _pext_u64(subset, occupancyMask)] = BitboardGenerator::generateBishopMoveset(square, subset);
-            bishopMovementIndex++;
-
-            subset = (subset - occupancyMask) & occupancyMask;
-        } while (subset);
-    }
-}
-
-void ChessEngine::addPawnMoves(MoveList& moveList, const uint64_t mask) const
-{
-    uint64_t pawns = pieces[activePlayer][PAWN];
-    uint64_t allPiecesOnBoard = allPieces[activePlayer] | allPieces[activePlayer ^ 1];
-    uint64_t doublePushRank = activePlayer == Color::WHITE ? BitboardGenerator::RANK_2 : BitboardGenerator::RANK_7;
-    uint64_t promotionRank = activePlayer == Color::WHITE ? BitboardGenerator::RANK_7 : BitboardGenerator::RANK_2;
-
-    while (pawns)
-    {
-        // Get the LSB
-        int square = _tzcnt_u64(pawns);
-
-        // Bitboard containing the currently processed pawn
-        uint64_t singlePawnBitboard = 1ULL << square;
-
-        // Add pawn pushes
-        if (!(pawnPushes[activePlayer][square] & allPiecesOnBoard))
-        {
-            int pushSquare = _tzcnt_u64(pawnPushes[activePlayer][square]);
-
-            if (pawnPushes[activePlayer][square] & mask)
+            if (attackTables.pawnPushes[color][square] & mask)
             {
                 // Check for promotion possibility
                 if (singlePawnBitboard & promotionRank)
@@ -614,13 +1114,13 @@ void ChessEngine::addPawnMoves(MoveList& moveList, const uint64_t mask) const
             // Check for double push possibility
             if (singlePawnBitboard & doublePushRank)
             {
-                if (!(pawnPushes[activePlayer][pushSquare] & allPiecesOnBoard) && (pawnPushes[activePlayer][pushSquare] & mask))
-                    moveList.add(Move(square, _tzcnt_u64(pawnPushes[activePlayer][pushSquare])));
+                if (!(attackTables.pawnPushes[color][pushSquare] & allPiecesOnBoard) && (attackTables.pawnPushes[color][pushSquare] & mask))
+                    moveList.add(Move(square, _tzcnt_u64(attackTables.pawnPushes[color][pushSquare])));
             }
         }
 
         // Add pawn attacks
-        uint64_t successfulAttacks = (pawnAttacks[activePlayer][square] & (allPieces[activePlayer ^ 1] & ~pieces[activePlayer ^ 1][KING])) & mask; // The enemy king can not be captured
+        uint64_t successfulAttacks = (attackTables.pawnAttacks[color][square] & (allPieces[enemyColor] & ~pieces[enemyColor][KING])) & mask; // The enemy king can not be captured
         while (successfulAttacks)
         {
             int attackedSquare = _tzcnt_u64(successfulAttacks);
@@ -640,8 +1140,8 @@ void ChessEngine::addPawnMoves(MoveList& moveList, const uint64_t mask) const
             successfulAttacks &= successfulAttacks - 1;
         }
 
-        // Add en passant attack
-        if (pawnAttacks[activePlayer][square] & enPassantTargetBitboard)
+        // Add en passant attack (tested on the board after the capture, which handles pins, checks and the two pawns leaving a rank)
+        if ((attackTables.pawnAttacks[color][square] & enPassantTargetBitboard) && isLegalEnPassant(square, _tzcnt_u64(enPassantTargetBitboard)))
         {
             // Add en passant attack
             moveList.add(Move(square, _tzcnt_u64(enPassantTargetBitboard), Move::MoveType::EN_PASSANT));
@@ -652,9 +1152,11 @@ void ChessEngine::addPawnMoves(MoveList& moveList, const uint64_t mask) const
     }
 }
 
+template <ChessEngine::Color color>
 void ChessEngine::addKnightMoves(MoveList& moveList, const uint64_t mask) const
 {
-    uint64_t knights = pieces[activePlayer][KNIGHT];
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    uint64_t knights = pieces[color][KNIGHT] & ~getAttackInfo().pinned; // A pinned knight can not move
 
     while (knights)
     {
@@ -662,7 +1164,7 @@ void ChessEngine::addKnightMoves(MoveList& moveList, const uint64_t mask) const
         int square = _tzcnt_u64(knights);
 
         // Add knight moves (the enemy king can not be captured)
-        uint64_t possibleMoves = knightMovement[square] & ~allPieces[activePlayer] & ~pieces[activePlayer ^ 1][KING] & mask;
+        uint64_t possibleMoves = attackTables.knightMovement[square] & ~allPieces[color] & ~pieces[enemyColor][KING] & mask;
         while (possibleMoves)
         {
             int attackedSquare = _tzcnt_u64(possibleMoves);
@@ -675,121 +1177,74 @@ void ChessEngine::addKnightMoves(MoveList& moveList, const uint64_t mask) const
     }
 }
 
+template <ChessEngine::Color color>
 void ChessEngine::addKingMoves(MoveList& movelist) const
 {
-    uint64_t king = pieces[activePlayer][KING];
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    uint64_t king = pieces[color][KING];
 
     while (king)
     {
         // Get the LSB
         int square = _tzcnt_u64(king);
 
-        // Add king moves (enemy king can not be captured)
-        uint64_t possibleMoves = kingMovement[square] & ~allPieces[activePlayer] & ~pieces[activePlayer ^ 1][KING];
+        // Add king moves (enemy king can not be captured) to the squares the enemy does not attack (the king does not block the line of a slider checking it)
+        uint64_t possibleMoves = attackTables.kingMovement[square] & ~allPieces[color] & ~pieces[enemyColor][KING];
+        const uint64_t occupancy = (allPieces[WHITE] | allPieces[BLACK]) ^ (1ULL << square);
         while (possibleMoves)
         {
             int attackedSquare = _tzcnt_u64(possibleMoves);
-            movelist.add(Move(square, attackedSquare));
+            if (!isAttacked(attackedSquare, enemyColor, occupancy))
+                movelist.add(Move(square, attackedSquare));
             possibleMoves &= possibleMoves - 1;
         }
 
-        // TODO Check attacks with an attack bitboard
-        if (activePlayer == Color::WHITE)
+        // The king can not castle out of check
+        const bool inCheck = getAttackInfo().checkers != 0ULL;
+        if (color == Color::WHITE && !inCheck)
         {
             if (castlingRights & whiteCastleQueenSide)
             {
-                if (!(squaresBetween[0][4] & (allPieces[activePlayer] | allPieces[activePlayer ^ 1])))
+                if (!(attackTables.squaresBetween[0][4] & (allPieces[color] | allPieces[enemyColor])))
                 {
-                    bool canCastle = true;
-
                     // Check the squares between the rook and the king (king included) for attacks
-                    uint64_t castleBitboard = squaresBetween[1][4] | (1ULL << square);
-                    while (castleBitboard)
-                    {
-                        int castleSquare = _tzcnt_u64(castleBitboard);
-                        if (isAttacked(castleSquare, static_cast<Color>(activePlayer ^ 1)))
-                        {
-                            canCastle = false;
-                            break;
-                        }
-                        castleBitboard &= castleBitboard - 1;
-                    }
-
-                    if (canCastle)
+                    uint64_t castleBitboard = attackTables.squaresBetween[1][4] | (1ULL << square);
+                    if (!(castleBitboard & getAttackMaps().attackedSquares[enemyColor]))
                         movelist.add(Move(square, 2, Move::MoveType::CASTLE));
                 }
             }
 
             if (castlingRights & whiteCastleKingSide)
             {
-                if (!(squaresBetween[7][4] & (allPieces[activePlayer] | allPieces[activePlayer ^ 1])))
+                if (!(attackTables.squaresBetween[7][4] & (allPieces[color] | allPieces[enemyColor])))
                 {
-                    bool canCastle = true;
-
                     // Check the squares between the rook and the king (king included) for attacks
-                    uint64_t castleBitboard = squaresBetween[7][4] | (1ULL << square);
-                    while (castleBitboard)
-                    {
-                        int castleSquare = _tzcnt_u64(castleBitboard);
-                        if (isAttacked(castleSquare, static_cast<Color>(activePlayer ^ 1)))
-                        {
-                            canCastle = false;
-                            break;
-                        }
-                        castleBitboard &= castleBitboard - 1;
-                    }
-
-                    if (canCastle)
+                    uint64_t castleBitboard = attackTables.squaresBetween[7][4] | (1ULL << square);
+                    if (!(castleBitboard & getAttackMaps().attackedSquares[enemyColor]))
                         movelist.add(Move(square, 6, Move::MoveType::CASTLE));
                 }
             }
         }
-        else if (activePlayer == Color::BLACK)
+        else if (color == Color::BLACK && !inCheck)
         {
             if (castlingRights & blackCastleQueenSide)
             {
-                if (!(squaresBetween[56][60] & (allPieces[activePlayer] | allPieces[activePlayer ^ 1])))
+                if (!(attackTables.squaresBetween[56][60] & (allPieces[color] | allPieces[enemyColor])))
                 {
-                    bool canCastle = true;
-
                     // Check the squares between the rook and the king (king included) for attacks
-                    uint64_t castleBitboard = squaresBetween[57][60] | (1ULL << square);
-                    while (castleBitboard)
-                    {
-                        int castleSquare = _tzcnt_u64(castleBitboard);
-                        if (isAttacked(castleSquare, static_cast<Color>(activePlayer ^ 1)))
-                        {
-                            canCastle = false;
-                            break;
-                        }
-                        castleBitboard &= castleBitboard - 1;
-                    }
-
-                    if (canCastle)
+                    uint64_t castleBitboard = attackTables.squaresBetween[57][60] | (1ULL << square);
+                    if (!(castleBitboard & getAttackMaps().attackedSquares[enemyColor]))
                         movelist.add(Move(square, 58, Move::MoveType::CASTLE));
                 }
             }
 
             if (castlingRights & blackCastleKingSide)
             {
-                if (!(squaresBetween[63][60] & (allPieces[activePlayer] | allPieces[activePlayer ^ 1])))
+                if (!(attackTables.squaresBetween[63][60] & (allPieces[color] | allPieces[enemyColor])))
                 {
-                    bool canCastle = true;
-
                     // Check the squares between the rook and the king (king included) for attacks
-                    uint64_t castleBitboard = squaresBetween[63][60] | (1ULL << square);
-                    while (castleBitboard)
-                    {
-                        int castleSquare = _tzcnt_u64(castleBitboard);
-                        if (isAttacked(castleSquare, static_cast<Color>(activePlayer ^ 1)))
-                        {
-                            canCastle = false;
-                            break;
-                        }
-                        castleBitboard &= castleBitboard - 1;
-                    }
-
-                    if (canCastle)
+                    uint64_t castleBitboard = attackTables.squaresBetween[63][60] | (1ULL << square);
+                    if (!(castleBitboard & getAttackMaps().attackedSquares[enemyColor]))
                         movelist.add(Move(square, 62, Move::MoveType::CASTLE));
                 }
             }
@@ -800,10 +1255,14 @@ void ChessEngine::addKingMoves(MoveList& movelist) const
     }
 }
 
+template <ChessEngine::Color color>
 void ChessEngine::addRookMoves(MoveList& movelist, const uint64_t mask) const
 {
-    uint64_t rooks = pieces[activePlayer][ROOK];
-    uint64_t allPiecesOnBoard = allPieces[activePlayer] | allPieces[activePlayer ^ 1];
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const AttackInfo& info = getAttackInfo();
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    uint64_t rooks = pieces[color][ROOK];
+    uint64_t allPiecesOnBoard = allPieces[color] | allPieces[enemyColor];
 
     while (rooks)
     {
@@ -811,9 +1270,11 @@ void ChessEngine::addRookMoves(MoveList& movelist, const uint64_t mask) const
         int square = _tzcnt_u64(rooks);
 
         // Get the rook moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-        uint64_t possibleMoves = rookMovement[rookSquareOffset[square] + _pext_u64(allPiecesOnBoard & rookOccupancyMask[square], rookOccupancyMask[square])];
-        possibleMoves &= ~allPieces[activePlayer]; // Remove the pieces of the same color from the attack set
+        uint64_t possibleMoves = sliderAttacks.getRookAttacks(square, allPiecesOnBoard);
+        possibleMoves &= ~allPieces[color]; // Remove the pieces of the same color from the attack set
         possibleMoves &= mask; // Only select moves within the mask
+        if ((1ULL << square) & info.pinned)
+            possibleMoves &= attackTables.lineThrough[kingSquare][square]; // A pinned piece can only move along the line through the king
         while (possibleMoves)
         {
             int attackedSquare = _tzcnt_u64(possibleMoves);
@@ -826,10 +1287,14 @@ void ChessEngine::addRookMoves(MoveList& movelist, const uint64_t mask) const
     }
 }
 
+template <ChessEngine::Color color>
 void ChessEngine::addBishopMoves(MoveList& movelist, const uint64_t mask) const
 {
-    uint64_t bishops = pieces[activePlayer][BISHOP];
-    uint64_t allPiecesOnBoard = allPieces[activePlayer] | allPieces[activePlayer ^ 1];
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const AttackInfo& info = getAttackInfo();
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    uint64_t bishops = pieces[color][BISHOP];
+    uint64_t allPiecesOnBoard = allPieces[color] | allPieces[enemyColor];
 
     while (bishops)
     {
@@ -837,9 +1302,11 @@ void ChessEngine::addBishopMoves(MoveList& movelist, const uint64_t mask) const
         int square = _tzcnt_u64(bishops);
 
         // Get the bishop moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-        uint64_t possibleMoves = bishopMovement[bishopSquareOffset[square] + _pext_u64(allPiecesOnBoard & bishopOccupancyMask[square], bishopOccupancyMask[square])];
-        possibleMoves &= ~allPieces[activePlayer]; // Remove the pieces of the same color from the attack set
+        uint64_t possibleMoves = sliderAttacks.getBishopAttacks(square, allPiecesOnBoard);
+        possibleMoves &= ~allPieces[color]; // Remove the pieces of the same color from the attack set
         possibleMoves &= mask; // Only select moves within the mask
+        if ((1ULL << square) & info.pinned)
+            possibleMoves &= attackTables.lineThrough[kingSquare][square]; // A pinned piece can only move along the line through the king
         while (possibleMoves)
         {
             int attackedSquare = _tzcnt_u64(possibleMoves);
@@ -852,10 +1319,14 @@ void ChessEngine::addBishopMoves(MoveList& movelist, const uint64_t mask) const
     }
 }
 
+template <ChessEngine::Color color>
 void ChessEngine::addQueenMoves(MoveList& movelist, const uint64_t mask) const
 {
-    uint64_t queens = pieces[activePlayer][QUEEN];
-    uint64_t allPiecesOnBoard = allPieces[activePlayer] | allPieces[activePlayer ^ 1];
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const AttackInfo& info = getAttackInfo();
+    const int kingSquare = _tzcnt_u64(pieces[color][KING]);
+    uint64_t queens = pieces[color][QUEEN];
+    uint64_t allPiecesOnBoard = allPieces[color] | allPieces[enemyColor];
 
     while (queens)
     {
@@ -863,13 +1334,15 @@ void ChessEngine::addQueenMoves(MoveList& movelist, const uint64_t mask) const
         int square = _tzcnt_u64(queens);
 
         // Get the rook moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-        uint64_t possibleRookMoves = rookMovement[rookSquareOffset[square] + _pext_u64(allPiecesOnBoard & rookOccupancyMask[square], rookOccupancyMask[square])];
+        uint64_t possibleRookMoves = sliderAttacks.getRookAttacks(square, allPiecesOnBoard);
         // Get the bishop moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-        uint64_t possibleBishopMoves = bishopMovement[bishopSquareOffset[square] + _pext_u64(allPiecesOnBoard & bishopOccupancyMask[square], bishopOccupancyMask[square])];
+        uint64_t possibleBishopMoves = sliderAttacks.getBishopAttacks(square, allPiecesOnBoard);
 
         // Combine the rook and bishop moves and remove own pieces from attack set
-        uint64_t possibleMoves = (possibleRookMoves | possibleBishopMoves) & ~allPieces[activePlayer];
+        uint64_t possibleMoves = (possibleRookMoves | possibleBishopMoves) & ~allPieces[color];
         possibleMoves &= mask; // Only select moves within the mask
+        if ((1ULL << square) & info.pinned)
+            possibleMoves &= attackTables.lineThrough[kingSquare][square]; // A pinned piece can only move along the line through the king
         while (possibleMoves)
         {
             int attackedSquare = _tzcnt_u64(possibleMoves);
@@ -884,103 +1357,36 @@ void ChessEngine::addQueenMoves(MoveList& movelist, const uint64_t mask) const
 
 bool ChessEngine::isAttacked(const int square, const Color color) const
 {
-    // Check for pawn attacks
-    if (pawnAttacks[color ^ 1][square] & pieces[color][PAWN])
+    return isAttacked(square, color, this->allPieces[WHITE] | this->allPieces[BLACK]);
+}
+
+bool ChessEngine::isAttacked(const int square, const Color color, const uint64_t occupancy) const
+{
+    // Check for pawn attacks (pieces missing from the occupancy are captured and do not attack)
+    if (attackTables.pawnAttacks[color ^ 1][square] & pieces[color][PAWN] & occupancy)
         return true;
 
     // Check for knight attacks
-    if (knightMovement[square] & pieces[color][KNIGHT])
+    if (attackTables.knightMovement[square] & pieces[color][KNIGHT] & occupancy)
         return true;
 
     // Check for king attacks
-    if (kingMovement[square] & pieces[color][KING])
+    if (attackTables.kingMovement[square] & pieces[color][KING])
         return true;
 
-    uint64_t allPieces = this->allPieces[WHITE] | this->allPieces[BLACK];
-
     // Check for rook attacks (queens included)
-    uint64_t rookAttacks = rookMovement[rookSquareOffset[square] + _pext_u64(allPieces & rookOccupancyMask[square], rookOccupancyMask[square])];
-    if (rookAttacks & (pieces[color][ROOK] | pieces[color][QUEEN]))
+    uint64_t rookAttacks = sliderAttacks.getRookAttacks(square, occupancy);
+    if (rookAttacks & (pieces[color][ROOK] | pieces[color][QUEEN]) & occupancy)
         return true;
 
     // Check for bishop attacks (queens included)
-    uint64_t bishopAttacks = bishopMovement[bishopSquareOffset[square] + _pext_u64(allPieces & bishopOccupancyMask[square], bishopOccupancyMask[square])];
-    if (bishopAttacks & (pieces[color][BISHOP] | pieces[color][QUEEN]))
+    uint64_t bishopAttacks = sliderAttacks.getBishopAttacks(square, occupancy);
+    if (bishopAttacks & (pieces[color][BISHOP] | pieces[color][QUEEN]) & occupancy)
         return true;
 
     return false;
 }
 
-uint64_t ChessEngine::getAttacksBitboard(const int square, const Color color) const
-{
-    // Get the other color
-    const Color otherColor = static_cast<Color>(color ^ 1);
-
-    // Bitboard of the attacking squares
-    uint64_t attackingSquares = 0ULL;
-
-    // Count pawn attacks
-    attackingSquares |= (pawnAttacks[otherColor][square] & pieces[color][PAWN]);
-    if ((attackingSquares & (attackingSquares - 1))) // Check if there are 2 attacks already (this is the maximum number of attacks)
-        return attackingSquares;
-
-    // Count knight attacks
-    attackingSquares |= (knightMovement[square] & pieces[color][KNIGHT]);
-    if ((attackingSquares & (attackingSquares - 1))) // Check if there are 2 attacks already (this is the maximum number of attacks)
-        return attackingSquares;
-
-    uint64_t allPieces = this->allPieces[WHITE] | this->allPieces[BLACK];
-
-    // Count rook attacks (queens included)
-    uint64_t rookAttacks = rookMovement[rookSquareOffset[square] + _pext_u64(allPieces & rookOccupancyMask[square], rookOccupancyMask[square])];
-    attackingSquares |= (rookAttacks & (pieces[color][ROOK] | pieces[color][QUEEN]));
-    if ((attackingSquares & (attackingSquares - 1))) // Check if there are 2 attacks already (this is the maximum number of attacks)
-        return attackingSquares;
-
-    // Count attacks (queens included)
-    uint64_t bishopAttacks = bishopMovement[bishopSquareOffset[square] + _pext_u64(allPieces & bishopOccupancyMask[square], bishopOccupancyMask[square])];
-    attackingSquares |= (bishopAttacks & (pieces[color][BISHOP] | pieces[color][QUEEN]));
-    if ((attackingSquares & (attackingSquares - 1))) // Check if there are 2 attacks already (this is the maximum number of attacks)
-        return attackingSquares;
-
-    return attackingSquares;
-}
-
-MoveList ChessEngine::getPseudolegalMovesInCheck(const uint64_t attackingSquares) const
-{
-    MoveList movelist;
-    int kingSquare = _tzcnt_u64(pieces[activePlayer][KING]);
-
-    if ((attackingSquares & (attackingSquares - 1)) == 0) // Only one piece attacking the king
-    {
-        // Generate moves that block the attack or capture the attacker
-        int attackingSquare = _tzcnt_u64(attackingSquares);
-        uint64_t mask = squaresBetween[kingSquare][attackingSquare] | attackingSquares;
-
-        addKingMoves(movelist);
-        addPawnMoves(movelist, mask);
-        addKnightMoves(movelist, mask);
-        addRookMoves(movelist, mask);
-        addBishopMoves(movelist, mask);
-        addQueenMoves(movelist, mask);
-
-        return movelist;
-    }
-    else // Two pieces attacking the king
-    {
-        // Generate only king moves (no castle)
-        uint64_t possibleMoves = kingMovement[kingSquare] & ~allPieces[activePlayer] & ~pieces[activePlayer ^ 1][KING];
-        while (possibleMoves)
-        {
-            int escapeSquare = _tzcnt_u64(possibleMoves);
-            movelist.add(Move(kingSquare, escapeSquare));
-            possibleMoves &= possibleMoves - 1;
-        }
-    }
-
-    return movelist;
-}
-
 bool ChessEngine::isValid(const Move move)
 {
     Color colorToMove = this->activePlayer;
@@ -1014,17 +1420,17 @@ bool ChessEngine::isValid(const Move move)
         {
             uint64_t doublePushRank = this->activePlayer == Color::WHITE ? BitboardGenerator::RANK_2 : BitboardGenerator::RANK_7;
 
-            if (toSquareMask & pawnPushes[colorToMove][fromSquare]) // Simple pawn push
+            if (toSquareMask & attackTables.pawnPushes[colorToMove][fromSquare]) // Simple pawn push
             {
                 if (toSquareMask & allPiecesOnBoard)
                     return false;
             }
             else if ((fromSquareMask & doublePushRank) && toSquareMask == BitboardGenerator::north(BitboardGenerator::north(fromSquareMask))) // Double pawn push
             {
-                if ((pawnPushes[colorToMove][fromSquare] | toSquareMask) & allPiecesOnBoard)
+                if ((attackTables.pawnPushes[colorToMove][fromSquare] | toSquareMask) & allPiecesOnBoard)
                     return false;
             }
-            else if (toSquareMask & pawnAttacks[colorToMove][fromSquare]) // Pawn attack
+            else if (toSquareMask & attackTables.pawnAttacks[colorToMove][fromSquare]) // Pawn attack
             {
                 if (!(toSquareMask & allPieces[colorToMove ^ 1]))
                     return false;
@@ -1039,21 +1445,21 @@ bool ChessEngine::isValid(const Move move)
 
         case KNIGHT:
             // Check if the move is valid
-            if (!(knightMovement[fromSquare] & toSquareMask))
+            if (!(attackTables.knightMovement[fromSquare] & toSquareMask))
                 return false;
               
             break;
 
         case KING:
             // Check if the move is valid
-            if (!(kingMovement[fromSquare] & toSquareMask))
+            if (!(attackTables.kingMovement[fromSquare] & toSquareMask))
                 return false;
             
             break;
 
         case ROOK:
         {
-            possibleMoves = rookMovement[rookSquareOffset[fromSquare] + _pext_u64(allPiecesOnBoard & rookOccupancyMask[fromSquare], rookOccupancyMask[fromSquare])];
+            possibleMoves = sliderAttacks.getRookAttacks(fromSquare, allPiecesOnBoard);
             if (!(toSquareMask & possibleMoves))
                 return false;
         }
@@ -1062,7 +1468,7 @@ bool ChessEngine::isValid(const Move move)
 
         case BISHOP:
         {
-            possibleMoves = bishopMovement[bishopSquareOffset[fromSquare] + _pext_u64(allPiecesOnBoard & bishopOccupancyMask[fromSquare], bishopOccupancyMask[fromSquare])];
+            possibleMoves = sliderAttacks.getBishopAttacks(fromSquare, allPiecesOnBoard);
             if (!(toSquareMask & possibleMoves))
                 return false;
         }
@@ -1072,9 +1478,9 @@ bool ChessEngine::isValid(const Move move)
         case QUEEN:
         {
             // Get the rook moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-            uint64_t possibleRookMoves = rookMovement[rookSquareOffset[fromSquare] + _pext_u64(allPiecesOnBoard & rookOccupancyMask[fromSquare], rookOccupancyMask[fromSquare])];
+            uint64_t possibleRookMoves = sliderAttacks.getRookAttacks(fromSquare, allPiecesOnBoard);
             // Get the bishop moves from the pre-generated movement bitboards (use PEXT to hash the current board)
-            uint64_t possibleBishopMoves = bishopMovement[bishopSquareOffset[fromSquare] + _pext_u64(allPiecesOnBoard & bishopOccupancyMask[fromSquare], bishopOccupancyMask[fromSquare])];
+            uint64_t possibleBishopMoves = sliderAttacks.getBishopAttacks(fromSquare, allPiecesOnBoard);
             // Combine the rook and bishop moves
             possibleMoves = (possibleRookMoves | possibleBishopMoves);
             if (!(toSquareMask & possibleMoves))
@@ -1100,7 +1506,7 @@ bool ChessEngine::isValid(const Move move)
             return false;
 
         // Check if the move is valid
-        if (!(toSquareMask & (pawnPushes[colorToMove][fromSquare] | pawnAttacks[colorToMove][fromSquare])))
+        if (!(toSquareMask & (attackTables.pawnPushes[colorToMove][fromSquare] | attackTables.pawnAttacks[colorToMove][fromSquare])))
             return false;
     }
 
@@ -1115,76 +1521,52 @@ bool ChessEngine::isValid(const Move move)
             if (!(this->castlingRights & this->blackCastleQueenSide))
                 return false;
 
-            if (!(squaresBetween[56][60] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1])))
-            {
-                // Check the squares between the rook and the king (king included) for attacks
-                uint64_t castleBitboard = squaresBetween[57][61];
-                while (castleBitboard)
-                {
-                    int castleSquare = _tzcnt_u64(castleBitboard);
-                    if (isAttacked(castleSquare, static_cast<Color>(colorToMove ^ 1)))
-                        return false;
+            // The squares between the rook and the king have to be empty
+            if (attackTables.squaresBetween[56][60] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1]))
+                return false;
 
-                    castleBitboard &= castleBitboard - 1;
-                }
-            }
+            // Check the squares the king crosses (king included) for attacks
+            if (attackTables.squaresBetween[57][61] & getAttackMaps().attackedSquares[colorToMove ^ 1])
+                return false;
         }
         else if (toSquare == 62) // Black king side
         {
             if (!(this->castlingRights & this->blackCastleKingSide))
                 return false;
 
-            if (!(squaresBetween[60][63] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1])))
-            {
-                // Check the squares between the rook and the king (king included) for attacks
-                uint64_t castleBitboard = squaresBetween[59][63];
-                while (castleBitboard)
-                {
-                    int castleSquare = _tzcnt_u64(castleBitboard);
-                    if (isAttacked(castleSquare, static_cast<Color>(colorToMove ^ 1)))
-                        return false;
+            // The squares between the rook and the king have to be empty
+            if (attackTables.squaresBetween[60][63] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1]))
+                return false;
 
-                    castleBitboard &= castleBitboard - 1;
-                }
-            }
+            // Check the squares the king crosses (king included) for attacks
+            if (attackTables.squaresBetween[59][63] & getAttackMaps().attackedSquares[colorToMove ^ 1])
+                return false;
         }
         else if (toSquare == 2) // White queen side
         {
             if (!(this->castlingRights & this->whiteCastleQueenSide))
                 return false;
 
-            if (!(squaresBetween[0][4] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1])))
-            {
-                // Check the squares between the rook and the king (king included) for attacks
-                uint64_t castleBitboard = squaresBetween[1][5];
-                while (castleBitboard)
-                {
-                    int castleSquare = _tzcnt_u64(castleBitboard);
-                    if (isAttacked(castleSquare, static_cast<Color>(colorToMove ^ 1)))
-                        return false;
+            // The squares between the rook and the king have to be empty
+            if (attackTables.squaresBetween[0][4] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1]))
+                return false;
 
-                    castleBitboard &= castleBitboard - 1;
-                }
-            }
+            // Check the squares the king crosses (king included) for attacks
+            if (attackTables.squaresBetween[1][5] & getAttackMaps().attackedSquares[colorToMove ^ 1])
+                return false;
         }
         else if (toSquare == 6) // White king side
         {
             if (!(this->castlingRights & this->whiteCastleKingSide))
                 return false;
 
-            if (!(squaresBetween[4][7] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1])))
-            {
-                // Check the squares between the rook and the king (king included) for attacks
-                uint64_t castleBitboard = squaresBetween[3][7];
-                while (castleBitboard)
-                {
-                    int castleSquare = _tzcnt_u64(castleBitboard);
-                    if (isAttacked(castleSquare, static_cast<Color>(colorToMove ^ 1)))
-                        return false;
+            // The squares between the rook and the king have to be empty
+            if (attackTables.squaresBetween[4][7] & (allPieces[colorToMove] | allPieces[colorToMove ^ 1]))
+                return false;
 
-                    castleBitboard &= castleBitboard - 1;
-                }
-            }
+            // Check the squares the king crosses (king included) for attacks
+            if (attackTables.squaresBetween[3][7] & getAttackMaps().attackedSquares[colorToMove ^ 1])
+                return false;
         }
         else // Invalid castle
         {
@@ -1208,11 +1590,7 @@ bool ChessEngine::isValid(const Move move)
     }
 
     // Check if the move is legal
-    makeMove(move);
-    bool isLegal = !isAttacked(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1));
-    undoMove();
-
-    return isLegal;
+    return isLegal(move);
 }
 
 bool ChessEngine::compareMoves(const Move firstMove, const Move secondMove) const
@@ -1276,41 +1654,408 @@ void ChessEngine::sortMoves(MoveList& movelist) const
     std::sort(movelist.moves, movelist.moves + movelist.numberOfMoves, [&](const Move& a, const Move& b) { return this->compareMoves(a, b); });
 }
 
-int ChessEngine::evaluate() const
+int ChessEngine::evaluate(const int alpha, const int beta)
 {
-    int result = 0;
+    this->evaluationCacheStatistics.probes++;
 
-    // Add white's score to the result
-    for (int type = 0; type < 6; type++)
+    // Positions reached again by transposition are not evaluated again
+    EvaluationCacheEntry& entry = this->evaluationCache[this->boardZobristHash & (this->evaluationCacheSize - 1)];
+    if (entry.zobristHash == this->boardZobristHash)
     {
-        uint64_t bitboard = pieces[WHITE][type];
+        this->evaluationCacheStatistics.hits++;
+        return entry.score;
+    }
 
-        while (bitboard)
+    if (this->network.isLoaded())
+    {
+        entry.zobristHash = this->boardZobristHash;
+        entry.score = evaluateNetwork();
+        return entry.score;
+    }
+
+    const unsigned long long start = __rdtsc();
+
+    // Far enough outside the window the pawn structure can not change which side of it the score is on, so the bound of the score given by
+    // the cheap terms is returned (it is not cached). Scaled endgames are left to the full evaluation, as scaling can move the score toward the window
+    const MaterialHashTableEntry& material = probeMaterialHashTable();
+    if (material.endgameEvaluator == nullptr && material.scaleFactor[WHITE] == NORMAL_SCALE_FACTOR && material.scaleFactor[BLACK] == NORMAL_SCALE_FACTOR)
+    {
+        const int lazyScore = computeLazyEvaluation(material);
+        const int bound = lazyScore + LAZY_EVALUATION_MARGIN <= alpha ? lazyScore + LAZY_EVALUATION_MARGIN :
+            lazyScore - LAZY_EVALUATION_MARGIN >= beta ? lazyScore - LAZY_EVALUATION_MARGIN : INT_MIN;
+
+        if (bound != INT_MIN)
         {
-            int square = _tzcnt_u64(bitboard);
+            this->lazyEvaluationStatistics.lazyExits++;
+            this->lazyEvaluationStatistics.lazyCycles += __rdtsc() - start;
+            return bound;
+        }
+    }
 
-            result += pieceValue[type] + positionValue[type][square];
+    entry.zobristHash = this->boardZobristHash;
+    entry.score = computeEvaluation();
 
-            bitboard &= bitboard - 1;
+    this->lazyEvaluationStatistics.fullEvaluations++;
+    this->lazyEvaluationStatistics.fullCycles += __rdtsc() - start;
+
+    return entry.score;
+}
+
+int ChessEngine::evaluateNetwork()
+{
+    // Material signatures with endgame knowledge keep their own function
+    const MaterialHashTableEntry& material = probeMaterialHashTable();
+    if (material.endgameEvaluator != nullptr)
+        return (this->*material.endgameEvaluator)(material.strongSide);
+
+    updateAccumulator();
+
+    // The network scores the position for the side to move
+    const int score = this->network.evaluate(this->accumulatorStack[this->accumulatorPly], this->activePlayer);
+    return this->activePlayer == Color::WHITE ? score : -score;
+}
+
+void ChessEngine::pushAccumulator(const Move move)
+{
+    // Past the end of the stack the last accumulator is refreshed from the board for every position
+    if (this->accumulatorPly + 1 == this->accumulatorStackSize)
+    {
+        this->accumulatorOverflow++;
+        this->accumulatorStack[this->accumulatorPly].computed = false;
+        this->accumulatorUpdates[this->accumulatorPly].valid = false;
+        return;
+    }
+
+    this->accumulatorPly++;
+    this->accumulatorStack[this->accumulatorPly].computed = false;
+
+    // Only the changed pieces are recorded here, as most moves made for legality checks are never evaluated
+    AccumulatorUpdate& update = this->accumulatorUpdates[this->accumulatorPly];
+    update.numberOfRemoved = 0;
+    update.numberOfAdded = 0;
+    update.valid = true;
+
+    const Color color = this->activePlayer;
+    const Color enemyColor = static_cast<Color>(color ^ 1);
+    const int fromSquare = move.from();
+    const int toSquare = move.to();
+
+    // Nothing changes on the board for a null move
+    if (move.isNull())
+        return;
+
+    switch (move.moveType())
+    {
+    case Move::MoveType::NORMAL:
+        update.remove(color, squarePieceType[fromSquare], fromSquare);
+        update.add(color, squarePieceType[fromSquare], toSquare);
+        if (squarePieceType[toSquare] != PieceType::NONE)
+            update.remove(enemyColor, squarePieceType[toSquare], toSquare);
+        break;
+
+    case Move::MoveType::PROMOTION:
+        update.remove(color, PAWN, fromSquare);
+        update.add(color, promotionPieceToPieceType[move.promotionPiece()], toSquare);
+        if (squarePieceType[toSquare] != PieceType::NONE)
+            update.remove(enemyColor, squarePieceType[toSquare], toSquare);
+        break;
+
+    case Move::MoveType::CASTLE:
+        // The rook jumps over the king to the square next to it
+        update.remove(color, KING, fromSquare);
+        update.add(color, KING, toSquare);
+        update.remove(color, ROOK, toSquare > fromSquare ? toSquare + 1 : toSquare - 2);
+        update.add(color, ROOK, toSquare > fromSquare ? toSquare - 1 : toSquare + 1);
+        break;
+
+    case Move::MoveType::EN_PASSANT:
+        update.remove(color, PAWN, fromSquare);
+        update.add(color, PAWN, toSquare);
+        update.remove(enemyColor, PAWN, color == Color::WHITE ? toSquare - 8 : toSquare + 8);
+        break;
+    }
+}
+
+void ChessEngine::updateAccumulator()
+{
+    // Find the closest computed accumulator that the recorded moves lead from
+    int ply = this->accumulatorPly;
+    while (!this->accumulatorStack[ply].computed && ply > 0 && this->accumulatorUpdates[ply].valid)
+        ply--;
+
+    // Without one, the recorded moves are undone on a copy of the pieces to compute the bottom of the chain (so its other children reuse it)
+    if (!this->accumulatorStack[ply].computed)
+    {
+        uint64_t pieces[2][6];
+        memcpy(pieces, this->pieces, sizeof(pieces));
+        for (int i = this->accumulatorPly; i > ply; i--)
+        {
+            const AccumulatorUpdate& update = this->accumulatorUpdates[i];
+            for (int j = 0; j < update.numberOfAdded; j++)
+                pieces[update.added[j][0]][update.added[j][1]] ^= 1ULL << update.added[j][2];
+            for (int j = 0; j < update.numberOfRemoved; j++)
+                pieces[update.removed[j][0]][update.removed[j][1]] ^= 1ULL << update.removed[j][2];
         }
+        this->network.refresh(this->accumulatorStack[ply], pieces);
     }
 
-    // Subtract black's score from the result
-    for (int type = 0; type < 6; type++)
+    for (ply++; ply <= this->accumulatorPly; ply++)
+        this->network.update(this->accumulatorStack[ply - 1], this->accumulatorStack[ply], this->accumulatorUpdates[ply]);
+}
+
+void ChessEngine::popAccumulator()
+{
+    if (this->accumulatorOverflow > 0)
+    {
+        this->accumulatorOverflow--;
+        this->accumulatorStack[this->accumulatorPly].computed = false;
+    }
+    else if (this->accumulatorPly > 0)
     {
-        uint64_t bitboard = pieces[BLACK][type];
+        this->accumulatorPly--;
+    }
+    else
+    {
+        // Undoing a move made before the stack was reset
+        this->accumulatorStack[0].computed = false;
+    }
+}
 
-        while (bitboard)
+void ChessEngine::resetAccumulatorStack()
+{
+    // Past the end of the stack the last accumulator does not match the position
+    if (this->accumulatorOverflow > 0)
+    {
+        this->accumulatorStack[0].computed = false;
+    }
+    else if (this->accumulatorPly > 0)
+    {
+        if (this->network.isLoaded())
+            updateAccumulator();
+        this->accumulatorStack[0] = this->accumulatorStack[this->accumulatorPly];
+    }
+
+    this->accumulatorPly = 0;
+    this->accumulatorOverflow = 0;
+}
+
+void ChessEngine::clearAccumulatorStack()
+{
+    this->accumulatorStack[0].computed = false;
+    this->accumulatorPly = 0;
+    this->accumulatorOverflow = 0;
+}
+
+bool ChessEngine::setEvalFile(const std::string& path)
+{
+    if (path.empty())
+        this->network.unload();
+    else if (!this->network.load(path))
+        return false;
+
+    // Cached evaluations and accumulators belong to the previous evaluation
+    clearEvaluationCache();
+    clearAccumulatorStack();
+
+    return true;
+}
+
+void ChessEngine::clearEvaluationCache()
+{
+    for (int i = 0; i < this->evaluationCacheSize; i++)
+        this->evaluationCache[i] = EvaluationCacheEntry();
+}
+
+int ChessEngine::computeLazyEvaluation(const MaterialHashTableEntry& material) const
+{
+    // The material and positional score and the game phase are kept up to date by makeMove and undoMove, so tapering between the
+    // middle game and the end game score is all that is left (promotions can push the phase above its starting value)
+    const int phase = std::min(this->gamePhase, TOTAL_PHASE);
+    const int result = (middlegameScore(this->pieceSquareScore) * phase + endgameScore(this->pieceSquareScore) * (TOTAL_PHASE - phase)) / TOTAL_PHASE;
+
+    return result + material.imbalance;
+}
+
+int ChessEngine::computeEvaluation() const
+{
+    // Material signatures with endgame knowledge are evaluated by their own function
+    const MaterialHashTableEntry& material = probeMaterialHashTable();
+    if (material.endgameEvaluator != nullptr)
+        return (this->*material.endgameEvaluator)(material.strongSide);
+
+    int result = computeLazyEvaluation(material);
+
+    // Add the pawn structure score (rarely changes, so it is almost always found in the pawn hash table)
+    result += probePawnHashTable().score;
+
+    // Scale down endgames that are hard to win for the side that is ahead
+    return result * material.scaleFactor[result > 0 ? WHITE : BLACK] / NORMAL_SCALE_FACTOR;
+}
+
+const ChessEngine::MaterialHashTableEntry& ChessEngine::probeMaterialHashTable() const
+{
+    MaterialHashTableEntry& entry = this->materialHashTable[this->materialZobristHash & (this->materialHashTableSize - 1)];
+    if (entry.materialZobristHash != this->materialZobristHash)
+    {
+        evaluateMaterial(entry);
+        entry.materialZobristHash = this->materialZobristHash;
+    }
+
+    return entry;
+}
+
+void ChessEngine::evaluateMaterial(MaterialHashTableEntry& entry) const
+{
+    int count[2][6];
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+            count[color][type] = static_cast<int>(_mm_popcnt_u64(pieces[color][type]));
+
+    entry.imbalance = 0;
+    entry.endgameEvaluator = nullptr;
+    entry.strongSide = WHITE;
+
+    int nonPawnMaterial[2];
+    for (int color = 0; color < 2; color++)
+    {
+        const int sign = color == WHITE ? 1 : -1;
+
+        nonPawnMaterial[color] = 0;
+        for (int type = KNIGHT; type <= QUEEN; type++)
+        {
+            nonPawnMaterial[color] += count[color][type] * pieceValue[type];
+        }
+
+        // Bishop pair, knights are better with many pawns on the board and rooks with few
+        if (count[color][BISHOP] >= 2)
+            entry.imbalance += sign * BISHOP_PAIR_BONUS;
+        entry.imbalance += sign * count[color][KNIGHT] * (count[color][PAWN] - 5) * KNIGHT_PAWN_ADJUSTMENT;
+        entry.imbalance -= sign * count[color][ROOK] * (count[color][PAWN] - 5) * ROOK_PAWN_ADJUSTMENT;
+    }
+
+    for (int color = 0; color < 2; color++)
+    {
+        // Without pawns, being up by a minor piece or less is rarely enough to win
+        if (count[color][PAWN] == 0 && nonPawnMaterial[color] - nonPawnMaterial[color ^ 1] <= pieceValue[BISHOP])
+            entry.scaleFactor[color] = nonPawnMaterial[color] < pieceValue[ROOK] ? 0 : NORMAL_SCALE_FACTOR / 4;
+        else
+            entry.scaleFactor[color] = NORMAL_SCALE_FACTOR;
+    }
+
+    // No pawns, rooks or queens and at most a minor piece each (or two knights against a lone king) can not be won
+    const bool noMajorPiecesOrPawns = count[WHITE][PAWN] + count[BLACK][PAWN] + count[WHITE][ROOK] + count[BLACK][ROOK] + count[WHITE][QUEEN] + count[BLACK][QUEEN] == 0;
+    for (int color = 0; color < 2; color++)
+    {
+        const int minorPieces = count[color][KNIGHT] + count[color][BISHOP];
+        const int enemyMinorPieces = count[color ^ 1][KNIGHT] + count[color ^ 1][BISHOP];
+        if (noMajorPiecesOrPawns && ((minorPieces <= 1 && enemyMinorPieces <= 1) || (count[color][KNIGHT] == 2 && count[color][BISHOP] == 0 && enemyMinorPieces == 0)))
+        {
+            entry.endgameEvaluator = &ChessEngine::evaluateDraw;
+            return;
+        }
+    }
+
+    // A lone king against mating material
+    for (int color = 0; color < 2; color++)
+        if (nonPawnMaterial[color ^ 1] == 0 && count[color ^ 1][PAWN] == 0 && nonPawnMaterial[color] >= pieceValue[ROOK])
         {
-            int square = 63 - _tzcnt_u64(bitboard);
+            entry.endgameEvaluator = &ChessEngine::evaluateKXK;
+            entry.strongSide = static_cast<Color>(color);
+            return;
+        }
+}
+
+int ChessEngine::evaluateDraw(const Color /*strongSide*/) const
+{
+    return 0;
+}
 
-            result -= pieceValue[type] + positionValue[type][square];
+int ChessEngine::evaluateKXK(const Color strongSide) const
+{
+    const int strongKingSquare = _tzcnt_u64(pieces[strongSide][KING]);
+    const int weakKingSquare = _tzcnt_u64(pieces[strongSide ^ 1][KING]);
+
+    int result = 0;
+    for (int type = PAWN; type <= QUEEN; type++)
+    {
+        uint64_t bitboard = pieces[strongSide][type];
 
+        while (bitboard)
+        {
+            const int square = _tzcnt_u64(bitboard);
+            result += pieceValue[type] + positionValue[type][strongSide == WHITE ? square : 63 - square];
             bitboard &= bitboard - 1;
         }
     }
 
-    return result;
+    // Drive the weak king to the edge of the board and bring the strong king closer to it
+    const int weakKingFile = weakKingSquare & 7, weakKingRank = weakKingSquare >> 3;
+    const int distanceFromCenter = std::max(3 - weakKingFile, weakKingFile - 4) + std::max(3 - weakKingRank, weakKingRank - 4);
+    const int distanceBetweenKings = std::max(std::abs(weakKingFile - (strongKingSquare & 7)), std::abs(weakKingRank - (strongKingSquare >> 3)));
+    result += 20 * distanceFromCenter + 10 * (7 - distanceBetweenKings);
+
+    return strongSide == WHITE ? result : -result;
+}
+
+const ChessEngine::PawnHashTableEntry& ChessEngine::probePawnHashTable() const
+{
+    PawnHashTableEntry& entry = this->pawnHashTable[this->pawnZobristHash & (this->pawnHashTableSize - 1)];
+    if (entry.pawnZobristHash != this->pawnZobristHash)
+    {
+        evaluatePawnStructure(entry);
+        entry.pawnZobristHash = this->pawnZobristHash;
+    }
+
+    return entry;
+}
+
+void ChessEngine::evaluatePawnStructure(PawnHashTableEntry& entry) const
+{
+    const uint64_t whitePawns = pieces[WHITE][PAWN];
+    const uint64_t blackPawns = pieces[BLACK][PAWN];
+
+    // Squares the pawns attack now or after advancing (white pawns advance north, black pawns advance south)
+    entry.attackSpans[WHITE] = BitboardGenerator::northFill(BitboardGenerator::generatePawnAttack(whitePawns, WHITE));
+    entry.attackSpans[BLACK] = BitboardGenerator::southFill(BitboardGenerator::generatePawnAttack(blackPawns, BLACK));
+
+    // A pawn is passed if no enemy pawn is in front of it or can attack a square in front of it
+    entry.passedPawns[WHITE] = whitePawns & ~(BitboardGenerator::southFill(BitboardGenerator::south(blackPawns)) | entry.attackSpans[BLACK]);
+    entry.passedPawns[BLACK] = blackPawns & ~(BitboardGenerator::northFill(BitboardGenerator::north(whitePawns)) | entry.attackSpans[WHITE]);
+
+    int score = 0;
+    for (int color = 0; color < 2; color++)
+    {
+        const uint64_t pawns = pieces[color][PAWN];
+        const uint64_t enemyPawnAttacks = BitboardGenerator::generatePawnAttack(pieces[color ^ 1][PAWN], color ^ 1);
+        const int sign = color == WHITE ? 1 : -1;
+
+        // Pawns with another pawn of the same color behind them
+        const uint64_t doubledPawns = color == WHITE ? pawns & BitboardGenerator::northFill(BitboardGenerator::north(pawns)) : pawns & BitboardGenerator::southFill(BitboardGenerator::south(pawns));
+
+        // Pawns without pawns of the same color on the adjacent files
+        const uint64_t pawnFiles = BitboardGenerator::northFill(BitboardGenerator::southFill(pawns));
+        const uint64_t isolatedPawns = pawns & ~(BitboardGenerator::east(pawnFiles) | BitboardGenerator::west(pawnFiles));
+
+        // Pawns whose stop square is attacked by an enemy pawn and out of reach of the pawns of the same color
+        const uint64_t backwardPawns = color == WHITE ?
+            pawns & BitboardGenerator::south(BitboardGenerator::north(pawns) & enemyPawnAttacks & ~entry.attackSpans[WHITE]) :
+            pawns & BitboardGenerator::north(BitboardGenerator::south(pawns) & enemyPawnAttacks & ~entry.attackSpans[BLACK]);
+
+        score -= sign * static_cast<int>(_mm_popcnt_u64(doubledPawns)) * DOUBLED_PAWN_PENALTY;
+        score -= sign * static_cast<int>(_mm_popcnt_u64(isolatedPawns)) * ISOLATED_PAWN_PENALTY;
+        score -= sign * static_cast<int>(_mm_popcnt_u64(backwardPawns & ~isolatedPawns)) * BACKWARD_PAWN_PENALTY;
+
+        // Passed pawns are worth more the closer they are to promotion
+        uint64_t passedPawns = entry.passedPawns[color];
+        while (passedPawns)
+        {
+            const int rank = _tzcnt_u64(passedPawns) >> 3;
+            score += sign * PASSED_PAWN_BONUS[color == WHITE ? rank : 7 - rank];
+            passedPawns &= passedPawns - 1;
+        }
+    }
+
+    entry.score = score;
 }
 
 ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int depth, const int ply)
@@ -1320,7 +2065,7 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
     if (this->stopSearch)
         return SearchResult();
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
+    auto currentTime = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - this->searchStartTime).count();
     if (duration >= this->timeLimitInMilliseconds)
     {
@@ -1348,42 +2093,42 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
     const Color colorToMove = this->activePlayer;
 
     // Check the transposition table entry
-    int TTIndex = this->boardZobristHash & (this->transpositionTableSize - 1);
-    if (transpositionTable[TTIndex].zobristHash == this->boardZobristHash && transpositionTable[TTIndex].depth >= depth)
+    const TranspositionTableEntry TTEntry = probeTranspositionTable(depth);
+    if (TTEntry.zobristHash() == this->boardZobristHash && TTEntry.depth() >= depth)
     {
-        if (transpositionTable[TTIndex].nodeType == NodeType::EXACT)
-            if (isValid(transpositionTable[TTIndex].move))
-                return SearchResult(transpositionTable[TTIndex].move, transpositionTable[TTIndex].score);
+        if (TTEntry.nodeType() == NodeType::EXACT)
+            if (isValid(TTEntry.move()))
+                return SearchResult(TTEntry.move(), TTEntry.score());
 
         if (colorToMove == Color::WHITE)
         {
-            if (transpositionTable[TTIndex].nodeType == NodeType::LOWER_BOUND && transpositionTable[TTIndex].score >= beta)
-                if (isValid(transpositionTable[TTIndex].move))
-                    return SearchResult(transpositionTable[TTIndex].move, transpositionTable[TTIndex].score);
+            if (TTEntry.nodeType() == NodeType::LOWER_BOUND && TTEntry.score() >= beta)
+                if (isValid(TTEntry.move()))
+                    return SearchResult(TTEntry.move(), TTEntry.score());
 
-            if (transpositionTable[TTIndex].nodeType == NodeType::UPPER_BOUND && transpositionTable[TTIndex].score < alpha)
-                if (isValid(transpositionTable[TTIndex].move))
-                    return SearchResult(transpositionTable[TTIndex].move, transpositionTable[TTIndex].score);
+            if (TTEntry.nodeType() == NodeType::UPPER_BOUND && TTEntry.score() < alpha)
+                if (isValid(TTEntry.move()))
+                    return SearchResult(TTEntry.move(), TTEntry.score());
         }
         else
         {
-            if (transpositionTable[TTIndex].nodeType == NodeType::LOWER_BOUND && transpositionTable[TTIndex].score <= alpha)
-                if (isValid(transpositionTable[TTIndex].move))
-                    return SearchResult(transpositionTable[TTIndex].move, transpositionTable[TTIndex].score);
+            if (TTEntry.nodeType() == NodeType::LOWER_BOUND && TTEntry.score() <= alpha)
+                if (isValid(TTEntry.move()))
+                    return SearchResult(TTEntry.move(), TTEntry.score());
 
-            if (transpositionTable[TTIndex].nodeType == NodeType::UPPER_BOUND && transpositionTable[TTIndex].score > beta)
-                if (isValid(transpositionTable[TTIndex].move))
-                    return SearchResult(transpositionTable[TTIndex].move, transpositionTable[TTIndex].score);
+            if (TTEntry.nodeType() == NodeType::UPPER_BOUND && TTEntry.score() > beta)
+                if (isValid(TTEntry.move()))
+                    return SearchResult(TTEntry.move(), TTEntry.score());
         }
     }
 
     if (depth == 0)
-        return SearchResult(evaluate());
+        return SearchResult(evaluate(alpha, beta));
 
     // Store the current ply
     this->currentPly = ply;
 
-    uint64_t squaresAttackingKing = getAttacksBitboard(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1));
+    uint64_t squaresAttackingKing = getAttackInfo().checkers;
 
     if (!this->isAtRoot && !squaresAttackingKing && depth >= NULL_MOVE_DEPTH_THRESHOLD) // Null move pruning
     {
@@ -1421,7 +2166,7 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
 
     this->isAtRoot = false;
 
-    MoveList moves = squaresAttackingKing != 0ULL ? getPseudolegalMovesInCheck(squaresAttackingKing) : getPseudolegalMoves();
+    MoveList moves = getLegalMoves();
     sortMoves(moves);
     
     if (colorToMove == Color::WHITE)
@@ -1432,39 +2177,34 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
         for (int i = 0; i < moves.numberOfMoves; i++)
         {
             makeMove(moves.moves[i]);
+            SearchResult moveResult(moves.moves[i], minimax(alpha, beta, depth - 1, ply + 1).score);
 
-            // Check if the move is legal
-            if (!isAttacked(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1)))
+            if (moveResult.score > result.score)
             {
-                SearchResult moveResult(moves.moves[i], minimax(alpha, beta, depth - 1, ply + 1).score);
+                result = moveResult;
 
-                if (moveResult.score > result.score)
-                {
-                    result = moveResult;
+                if (moveResult.score > alpha)
+                    alpha = moveResult.score;
+            }
+            
+            if (moveResult.score >= beta)
+            {
+                undoMove();
 
-                    if (moveResult.score > alpha)
-                        alpha = moveResult.score;
-                }
-                
-                if (moveResult.score >= beta)
+                if (!this->stopSearch)
                 {
-                    undoMove();
+                    // Store the result in the transposition table
+                    storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::LOWER_BOUND));
 
-                    if (!this->stopSearch)
+                    // Update the killer and history tables for non capture moves
+                    if (squarePieceType[moves.moves[i].to()] == PieceType::NONE)
                     {
-                        // Store the result in the transposition table
-                        transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::LOWER_BOUND);
-
-                        // Update the killer and history tables for non capture moves
-                        if (squarePieceType[moves.moves[i].to()] == PieceType::NONE)
-                        {
-                            updateKillerMoves(moves.moves[i], ply);
-                            updateHistoryTable(colorToMove, moves.moves[i], depth);
-                        }
+                        updateKillerMoves(moves.moves[i], ply);
+                        updateHistoryTable(colorToMove, moves.moves[i], depth);
                     }
-
-                    return result;
                 }
+
+                return result;
             }
 
             undoMove();
@@ -1482,9 +2222,9 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
         {
             // Store the result in the transposition table
             if (alpha > originalAlpha)
-                transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::EXACT);
+                storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::EXACT));
             else
-                transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::UPPER_BOUND);
+                storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::UPPER_BOUND));
 
             // Update the history table for non capture moves
             if (squarePieceType[result.move.to()] == PieceType::NONE)
@@ -1501,39 +2241,34 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
         for (int i = 0; i < moves.numberOfMoves; i++)
         {
             makeMove(moves.moves[i]);
+            SearchResult moveResult(moves.moves[i], minimax(alpha, beta, depth - 1, ply + 1).score);
 
-            // Check if the move is legal
-            if (!isAttacked(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1)))
+            if (moveResult.score < result.score)
             {
-                SearchResult moveResult(moves.moves[i], minimax(alpha, beta, depth - 1, ply + 1).score);
+                result = moveResult;
 
-                if (moveResult.score < result.score)
-                {
-                    result = moveResult;
+                if (moveResult.score < beta)
+                    beta = moveResult.score;
+            }
 
-                    if (moveResult.score < beta)
-                        beta = moveResult.score;
-                }
+            if (moveResult.score <= alpha)
+            {
+                undoMove();
 
-                if (moveResult.score <= alpha)
+                if (!this->stopSearch)
                 {
-                    undoMove();
+                    // Store the result in the transposition table
+                    storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::LOWER_BOUND));
 
-                    if (!this->stopSearch)
+                    // Update the killer and history tables for non capture moves
+                    if (squarePieceType[moves.moves[i].to()] == PieceType::NONE)
                     {
-                        // Store the result in the transposition table
-                        transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::LOWER_BOUND);
-
-                        // Update the killer and history tables for non capture moves
-                        if (squarePieceType[moves.moves[i].to()] == PieceType::NONE)
-                        {
-                            updateKillerMoves(moves.moves[i], ply);
-                            updateHistoryTable(colorToMove, moves.moves[i], depth);
-                        }
+                        updateKillerMoves(moves.moves[i], ply);
+                        updateHistoryTable(colorToMove, moves.moves[i], depth);
                     }
-
-                    return result;
                 }
+
+                return result;
             }
 
             undoMove();
@@ -1550,9 +2285,9 @@ ChessEngine::SearchResult ChessEngine::minimax(int alpha, int beta, const int de
         if (!this->stopSearch)
         {
             if (beta < originalBeta)
-                transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::EXACT);
+                storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::EXACT));
             else
-                transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::UPPER_BOUND);
+                storeTranspositionTableEntry(TranspositionTableEntry(this->boardZobristHash, result.move, result.score, depth, NodeType::UPPER_BOUND));
 
             // Update the history table for non capture moves
             if (squarePieceType[result.move.to()] == PieceType::NONE)
@@ -1627,7 +2362,7 @@ Move ChessEngine::getMoveFromString(const std::string moveString) const
         Move::MoveType movetype = Move::MoveType::NORMAL;
 
         // Check if the move is a castle
-        if (this->squarePieceType[fromSquare] == PieceType::KING && this->squaresBetween[fromSquare][toSquare])
+        if (this->squarePieceType[fromSquare] == PieceType::KING && attackTables.squaresBetween[fromSquare][toSquare])
             movetype = Move::MoveType::CASTLE;
 
         // Check if the move is an en passant
@@ -1659,442 +2394,248 @@ Move ChessEngine::getMoveFromString(const std::string moveString) const
     }
 }
 
-MoveList ChessEngine::getPseudolegalMoves() const
+MoveList ChessEngine::getLegalMoves() const
 {
-    MoveList moveList;
-
-    addPawnMoves(moveList);
-    addKnightMoves(moveList);
-    addKingMoves(moveList);
-    addRookMoves(moveList);
-    addBishopMoves(moveList);
-    addQueenMoves(moveList);
-
-    return moveList;
+    return this->activePlayer == Color::WHITE ? generateLegalMoves<Color::WHITE>() : generateLegalMoves<Color::BLACK>();
 }
 
-MoveList ChessEngine::getLegalMoves()
+template <ChessEngine::Color color>
+MoveList ChessEngine::generateLegalMoves() const
 {
-    const Color colorToMove = this->activePlayer;
-    MoveList pseudolegalMoves = getPseudolegalMoves();
-    MoveList legalMoves;
+    MoveList moveList;
+    const AttackInfo& info = getAttackInfo();
 
-    for (int i = 0; i < pseudolegalMoves.numberOfMoves; i++)
+    // Only the king can move out of a double check
+    if (info.checkers & (info.checkers - 1))
     {
-        makeMove(pseudolegalMoves.moves[i]);
-        if (!isAttacked(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1)))
-            legalMoves.add(pseudolegalMoves.moves[i]);
-        undoMove();
+        addKingMoves<color>(moveList);
+        return moveList;
     }
 
-    return legalMoves;
+    // Out of a single check the other pieces have to capture the checker or block it
+    uint64_t mask = 0xFFFFFFFFFFFFFFFF;
+    if (info.checkers)
+        mask = info.checkers | attackTables.squaresBetween[_tzcnt_u64(pieces[color][KING])][_tzcnt_u64(info.checkers)];
+
+    addPawnMoves<color>(moveList, mask);
+    addKnightMoves<color>(moveList, mask);
+    addKingMoves<color>(moveList);
+    addRookMoves<color>(moveList, mask);
+    addBishopMoves<color>(moveList, mask);
+    addQueenMoves<color>(moveList, mask);
+
+    return moveList;
 }
 
 void ChessEngine::makeMove(const Move move)
 {
+    // Update the network accumulator while the board still shows which pieces move
+    if (this->network.isLoaded())
+        pushAccumulator(move);
+
+    // The attack info of the new position is computed when it is needed
+    this->attackInfoPly++;
+    this->attackInfoStack[this->attackInfoPly & (this->attackInfoStackSize - 1)].ply = INT_MIN;
+
     // Update the fullmove counter
     if (this->activePlayer == Color::BLACK)
         this->fullmoveCounter++;
 
-    if (move.isNull()) // Make a null move
-    {
-        undoStack.push(UndoHelper(0, 0, castlingRights, enPassantTargetBitboard, halfmoveClock));
-
-        // Update the halfmove clock
-        this->halfmoveClock++;
-        
-        // Update zobrist hash for en passant target square
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        // Empty the en passant target bitboard
-        enPassantTargetBitboard = 0ULL;
-
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
-
-        // Store the zobrist hash of the position in the previous positions array
-        this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
-        this->previousPositionsSize++;
-
-        return;
-    }
-
     // Extract move information
-    uint8_t toSquare = move.to();
-    uint8_t fromSquare = move.from();
-    uint64_t toSquareMask = 1ULL << toSquare;
-    uint64_t fromSquareMask = 1ULL << fromSquare;
-    Move::MoveType moveType = move.moveType();
-
-    if (moveType == Move::MoveType::NORMAL)
-    {
-        // Find moving piece type
-        PieceType movingPieceType = squarePieceType[fromSquare];
-
-        // Move the piece
-        pieces[activePlayer][movingPieceType] ^= fromSquareMask;
-        pieces[activePlayer][movingPieceType] ^= toSquareMask;
-        allPieces[activePlayer] ^= fromSquareMask;
-        allPieces[activePlayer] ^= toSquareMask;
-        // Update zobrist hash for the moving piece
-        boardZobristHash ^= pieceZobristHash[movingPieceType][fromSquare];
-        boardZobristHash ^= pieceZobristHash[movingPieceType][toSquare];
-
-        // Find captured piece type
-        PieceType capturedPieceType = squarePieceType[toSquare];
-        
-        // Push the changes to the undo stack
-        undoStack.push(UndoHelper(fromSquare, toSquare, castlingRights, enPassantTargetBitboard, halfmoveClock, moveType, capturedPieceType));
-
-        // Update zobrist hash for en passant target square
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        // Empty the en passant target bitboard
-        enPassantTargetBitboard = 0ULL;
+    const int fromSquare = move.from();
+    const int toSquare = move.to();
+    const Move::MoveType moveType = move.moveType();
 
-        // Update the halfmove clock
-        halfmoveClock++;
-
-        // Capture the enemy piece
-        if (capturedPieceType != PieceType::NONE)
-        {
-            pieces[activePlayer ^ 1][capturedPieceType] ^= toSquareMask;
-            allPieces[activePlayer ^ 1] ^= toSquareMask;
-
-            // Update zobrist hash for captured piece
-            boardZobristHash ^= pieceZobristHash[capturedPieceType][toSquare];
+    // Push the state the move changes to the undo stack (a null move is stored as a move from and to square 0)
+    if (move.isNull())
+        undoStack.push(UndoHelper(0, 0, castlingRights, enPassantTargetBitboard, halfmoveClock));
+    else
+        undoStack.push(UndoHelper(fromSquare, toSquare, castlingRights, enPassantTargetBitboard, halfmoveClock, moveType, moveType == Move::MoveType::EN_PASSANT ? PieceType::PAWN : squarePieceType[toSquare]));
 
-            if (capturedPieceType == PieceType::ROOK)
-            {
-                switch (toSquare)
-                {
-                case 0:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~whiteCastleQueenSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 7:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~whiteCastleKingSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 56:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~blackCastleQueenSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 63:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~blackCastleKingSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                }
-            }
+    // Update zobrist hash for en passant target square
+    if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+    // Empty the en passant target bitboard
+    enPassantTargetBitboard = 0ULL;
 
-            // Reset the halfmove clock on a capture
-            this->halfmoveClock = 0;
-        }
+    // Update the halfmove clock (pawn moves and captures reset it)
+    this->halfmoveClock++;
 
-        // Update the array that stores piece types for each square
-        squarePieceType[fromSquare] = PieceType::NONE;
-        squarePieceType[toSquare] = movingPieceType;
+    if (!move.isNull())
+    {
+        // Moving a piece from or to a king or rook square loses the castling rights of that piece
+        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+        castlingRights &= castlingRightsKept[fromSquare] & castlingRightsKept[toSquare];
+        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
 
-        // Update castling rights
-        if (movingPieceType == KING)
+        if (this->activePlayer == Color::WHITE)
         {
-            if (activePlayer == Color::WHITE)
-            {
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~(whiteCastleQueenSide | whiteCastleKingSide);
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            }
-            else if (activePlayer == Color::BLACK)
+            switch (moveType)
             {
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~(blackCastleQueenSide | blackCastleKingSide);
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            }
-        }
-        else if (movingPieceType == ROOK)
-        {
-            switch (fromSquare)
-            {
-            case 0:
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~whiteCastleQueenSide;
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                break;
-            case 7:
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~whiteCastleKingSide;
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                break;
-            case 56:
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~blackCastleQueenSide;
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                break;
-            case 63:
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                castlingRights &= ~blackCastleKingSide;
-                boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                break;
+            case Move::MoveType::NORMAL: makeNormalMove<Color::WHITE>(fromSquare, toSquare); break;
+            case Move::MoveType::PROMOTION: makePromotion<Color::WHITE>(fromSquare, toSquare, promotionPieceToPieceType[move.promotionPiece()]); break;
+            case Move::MoveType::CASTLE: makeCastle<Color::WHITE>(fromSquare, toSquare); break;
+            case Move::MoveType::EN_PASSANT: makeEnPassant<Color::WHITE>(fromSquare, toSquare); break;
             }
         }
-        // Update en passant square if a pawn makes a double push
-        else if (movingPieceType == PAWN)
+        else
         {
-            if (squaresBetween[fromSquare][toSquare])
+            switch (moveType)
             {
-                if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-                enPassantTargetBitboard = squaresBetween[fromSquare][toSquare];
-                if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+            case Move::MoveType::NORMAL: makeNormalMove<Color::BLACK>(fromSquare, toSquare); break;
+            case Move::MoveType::PROMOTION: makePromotion<Color::BLACK>(fromSquare, toSquare, promotionPieceToPieceType[move.promotionPiece()]); break;
+            case Move::MoveType::CASTLE: makeCastle<Color::BLACK>(fromSquare, toSquare); break;
+            case Move::MoveType::EN_PASSANT: makeEnPassant<Color::BLACK>(fromSquare, toSquare); break;
             }
-
-            // Reset the halfmove clock on a pawn move
-            this->halfmoveClock = 0;
         }
-
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
-
-        // Store the zobrist hash of the position in the previous positions array
-        this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
-        this->previousPositionsSize++;
-
-        return;
     }
 
-    if (moveType == Move::MoveType::PROMOTION)
-    {
-        // Get promotion type
-        PieceType promotionType = promotionPieceToPieceType[move.promotionPiece()];
-
-        // Move and promote the pawn
-        pieces[activePlayer][PAWN] ^= fromSquareMask;
-        pieces[activePlayer][promotionType] ^= toSquareMask;
-        allPieces[activePlayer] ^= fromSquareMask;
-        allPieces[activePlayer] ^= toSquareMask;
-        // Update zobrist hash for the promoting pawn
-        boardZobristHash ^= pieceZobristHash[PAWN][fromSquare];
-        boardZobristHash ^= pieceZobristHash[promotionType][toSquare];
-
-        // Find captured piece type
-        PieceType capturedPieceType = squarePieceType[toSquare];
+    // Change the active player
+    this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
+    this->boardZobristHash ^= this->changePlayerZobristHash;
 
-        // Push the changes to the undo stack
-        undoStack.push(UndoHelper(fromSquare, toSquare, castlingRights, enPassantTargetBitboard, halfmoveClock, moveType, capturedPieceType));
-
-        // Update zobrist hash for en passant target square
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        // Empty the en passant target bitboard
-        enPassantTargetBitboard = 0ULL;
-
-        // Reset the halfmove clock on a pawn promotion
-        halfmoveClock = 0;
-
-        // Capture the enemy piece
-        if (capturedPieceType != PieceType::NONE)
-        {
-            pieces[activePlayer ^ 1][capturedPieceType] ^= toSquareMask;
-            allPieces[activePlayer ^ 1] ^= toSquareMask;
-
-            // Update zobrist hash for captured piece
-            boardZobristHash ^= pieceZobristHash[capturedPieceType][toSquare];
-
-            if (capturedPieceType == PieceType::ROOK)
-            {
-                switch (toSquare)
-                {
-                case 0:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~whiteCastleQueenSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 7:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~whiteCastleKingSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 56:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~blackCastleQueenSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                case 63:
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    castlingRights &= ~blackCastleKingSide;
-                    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-                    break;
-                }
-            }
-        }
+    // Store the zobrist hash of the position in the previous positions array
+    this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
+    this->previousPositionsSize++;
+}
 
-        // Update the array that stores piece types for each square
-        squarePieceType[fromSquare] = PieceType::NONE;
-        squarePieceType[toSquare] = promotionType;
+template <ChessEngine::Color color>
+void ChessEngine::movePiece(const PieceType pieceType, const int fromSquare, const int toSquare)
+{
+    const uint64_t fromToMask = (1ULL << fromSquare) | (1ULL << toSquare);
+
+    // Move the piece
+    pieces[color][pieceType] ^= fromToMask;
+    allPieces[color] ^= fromToMask;
+    squarePieceType[fromSquare] = PieceType::NONE;
+    squarePieceType[toSquare] = pieceType;
+    // Update the zobrist hash for the moving piece
+    boardZobristHash ^= pieceZobristHash[color][pieceType][fromSquare] ^ pieceZobristHash[color][pieceType][toSquare];
+    // Update the piece square score
+    pieceSquareScore += pieceSquareValue[color][pieceType][toSquare] - pieceSquareValue[color][pieceType][fromSquare];
+    // Update the pawn zobrist hash for a moving pawn
+    if (pieceType == PAWN)
+        pawnZobristHash ^= pieceZobristHash[color][PAWN][fromSquare] ^ pieceZobristHash[color][PAWN][toSquare];
+}
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+template <ChessEngine::Color color>
+void ChessEngine::removePiece(const PieceType pieceType, const int square)
+{
+    // Remove the piece
+    pieces[color][pieceType] ^= 1ULL << square;
+    allPieces[color] ^= 1ULL << square;
+    squarePieceType[square] = PieceType::NONE;
+    // Update the zobrist hash for the removed piece
+    boardZobristHash ^= pieceZobristHash[color][pieceType][square];
+    // Update the piece square score
+    pieceSquareScore -= pieceSquareValue[color][pieceType][square];
+    // Update the pawn zobrist hash for a removed pawn
+    if (pieceType == PAWN)
+        pawnZobristHash ^= pieceZobristHash[color][PAWN][square];
+    // Update the material zobrist hash for the removed piece (removes the hash of the remaining count)
+    materialZobristHash ^= pieceCountZobristHash[color][pieceType][_mm_popcnt_u64(pieces[color][pieceType])];
+    gamePhase -= PIECE_PHASE[pieceType];
+}
 
-        // Store the zobrist hash of the position in the previous positions array
-        this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
-        this->previousPositionsSize++;
+template <ChessEngine::Color color>
+void ChessEngine::addPiece(const PieceType pieceType, const int square)
+{
+    // Add the piece
+    pieces[color][pieceType] ^= 1ULL << square;
+    allPieces[color] ^= 1ULL << square;
+    squarePieceType[square] = pieceType;
+    // Update the zobrist hash for the added piece
+    boardZobristHash ^= pieceZobristHash[color][pieceType][square];
+    // Update the piece square score
+    pieceSquareScore += pieceSquareValue[color][pieceType][square];
+    // Update the pawn zobrist hash for an added pawn
+    if (pieceType == PAWN)
+        pawnZobristHash ^= pieceZobristHash[color][PAWN][square];
+    // Update the material zobrist hash for the added piece (adds the hash of the count before it was added)
+    materialZobristHash ^= pieceCountZobristHash[color][pieceType][_mm_popcnt_u64(pieces[color][pieceType]) - 1];
+    gamePhase += PIECE_PHASE[pieceType];
+}
 
-        return;
-    }
+template <ChessEngine::Color color>
+void ChessEngine::makeNormalMove(const int fromSquare, const int toSquare)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const PieceType movingPieceType = squarePieceType[fromSquare];
+    const PieceType capturedPieceType = squarePieceType[toSquare];
 
-    if (moveType == Move::MoveType::CASTLE)
+    // Capture the enemy piece (resets the halfmove clock)
+    if (capturedPieceType != PieceType::NONE)
     {
-        // Push the changes to the undo stack
-        undoStack.push(UndoHelper(fromSquare, toSquare, castlingRights, enPassantTargetBitboard, halfmoveClock, moveType, PieceType::NONE));
-
-        // Update zobrist hash for en passant target square
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        // Empty the en passant target bitboard
-        enPassantTargetBitboard = 0ULL;
-
-        // Update the halfmove clock
-        halfmoveClock++;
+        removePiece<enemyColor>(capturedPieceType, toSquare);
+        this->halfmoveClock = 0;
+    }
 
-        uint8_t rookToSquare = 0, rookFromSquare = 0;
-        uint64_t rookToSquareMask = 0, rookFromSquareMask = 0;
+    movePiece<color>(movingPieceType, fromSquare, toSquare);
 
-        // Identify the castle move
-        switch (toSquare)
+    if (movingPieceType == PAWN)
+    {
+        // Update en passant square if a pawn makes a double push
+        if (attackTables.squaresBetween[fromSquare][toSquare])
         {
-        case 2: // White queen side
-            rookFromSquare = 0, rookToSquare = 3;
-            rookFromSquareMask = 1ULL, rookToSquareMask = 1ULL << 3;
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            castlingRights &= ~(whiteCastleQueenSide | whiteCastleKingSide);
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            break;
-
-        case 6: // White king side
-            rookFromSquare = 7, rookToSquare = 5;
-            rookFromSquareMask = 1ULL << 7, rookToSquareMask = 1ULL << 5;
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            castlingRights &= ~(whiteCastleQueenSide | whiteCastleKingSide);
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            break;
-
-        case 58: // Black queen side
-            rookFromSquare = 56, rookToSquare = 59;
-            rookFromSquareMask = 1ULL << 56, rookToSquareMask = 1ULL << 59;
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            castlingRights &= ~(blackCastleQueenSide | blackCastleKingSide);
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            break;
-
-        case 62: // Black king side
-            rookFromSquare = 63, rookToSquare = 61;
-            rookFromSquareMask = 1ULL << 63, rookToSquareMask = 1ULL << 61;
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            castlingRights &= ~(blackCastleQueenSide | blackCastleKingSide);
-            boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-            break;
+            enPassantTargetBitboard = attackTables.squaresBetween[fromSquare][toSquare];
+            boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
         }
 
-        // Move the king
-        pieces[activePlayer][KING] ^= fromSquareMask;
-        pieces[activePlayer][KING] ^= toSquareMask;
-        allPieces[activePlayer] ^= fromSquareMask;
-        allPieces[activePlayer] ^= toSquareMask;
-        // Update zobrist hash for the moving king
-        boardZobristHash ^= pieceZobristHash[KING][fromSquare];
-        boardZobristHash ^= pieceZobristHash[KING][toSquare];
-
-        // Move the rook
-        pieces[activePlayer][ROOK] ^= rookFromSquareMask;
-        pieces[activePlayer][ROOK] ^= rookToSquareMask;
-        allPieces[activePlayer] ^= rookFromSquareMask;
-        allPieces[activePlayer] ^= rookToSquareMask;
-        // Update zobrist hash for the moving rook
-        boardZobristHash ^= pieceZobristHash[ROOK][rookFromSquare];
-        boardZobristHash ^= pieceZobristHash[ROOK][rookToSquare];
-
-        // Update the array that stores piece types for each square
-        squarePieceType[fromSquare] = PieceType::NONE;
-        squarePieceType[toSquare] = PieceType::KING;
-        squarePieceType[rookFromSquare] = PieceType::NONE;
-        squarePieceType[rookToSquare] = PieceType::ROOK;
-
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
-
-        // Store the zobrist hash of the position in the previous positions array
-        this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
-        this->previousPositionsSize++;
-
-        return;
+        // Reset the halfmove clock on a pawn move
+        this->halfmoveClock = 0;
     }
+}
 
-    if (moveType == Move::MoveType::EN_PASSANT)
-    {
-        // Move the pawn
-        pieces[activePlayer][PAWN] ^= fromSquareMask;
-        pieces[activePlayer][PAWN] ^= toSquareMask;
-        allPieces[activePlayer] ^= fromSquareMask;
-        allPieces[activePlayer] ^= toSquareMask;
-        // Update zobrist hash for the moving pawn
-        boardZobristHash ^= pieceZobristHash[PAWN][fromSquare];
-        boardZobristHash ^= pieceZobristHash[PAWN][toSquare];
-
-        // Push the changes to the undo stack
-        undoStack.push(UndoHelper(fromSquare, toSquare, castlingRights, enPassantTargetBitboard, halfmoveClock, moveType, PieceType::PAWN));
+template <ChessEngine::Color color>
+void ChessEngine::makePromotion(const int fromSquare, const int toSquare, const PieceType promotionType)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
+    const PieceType capturedPieceType = squarePieceType[toSquare];
 
-        // Update zobrist hash for en passant target square
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        // Empty the en passant target bitboard
-        enPassantTargetBitboard = 0ULL;
+    // Capture the enemy piece
+    if (capturedPieceType != PieceType::NONE)
+        removePiece<enemyColor>(capturedPieceType, toSquare);
 
-        // Reset the halfmove clock on an en passant move
-        halfmoveClock = 0;
+    // Replace the pawn by the promotion piece
+    removePiece<color>(PAWN, fromSquare);
+    addPiece<color>(promotionType, toSquare);
 
-        // Compute the captured pawn coordinates
-        int capturedPawnSquare = 0;
-        uint64_t capturedPawnMask = 0ULL;
-        if (activePlayer == Color::WHITE)
-        {
-            // Go one square down
-            capturedPawnSquare = toSquare - 8;
-            capturedPawnMask = 1ULL << capturedPawnSquare;
-        }
-        else if (activePlayer == Color::BLACK)
-        {
-            // Go one square up
-            capturedPawnSquare = toSquare + 8;
-            capturedPawnMask = 1ULL << capturedPawnSquare;
-        }
+    // Reset the halfmove clock on a pawn promotion
+    this->halfmoveClock = 0;
+}
 
-        // Capture the enemy pawn
-        pieces[activePlayer ^ 1][PAWN] ^= capturedPawnMask;
-        allPieces[activePlayer ^ 1] ^= capturedPawnMask;
-        // Update the zobrist hash for the captured pawn
-        boardZobristHash ^= pieceZobristHash[PAWN][capturedPawnSquare];
+template <ChessEngine::Color color>
+void ChessEngine::makeCastle(const int fromSquare, const int toSquare)
+{
+    // The rook jumps over the king to the square next to it
+    constexpr int rank = color == Color::WHITE ? 0 : 56;
+    const bool kingSide = toSquare > fromSquare;
 
-        // Update the array that stores piece types for each square
-        squarePieceType[fromSquare] = PieceType::NONE;
-        squarePieceType[toSquare] = PieceType::PAWN;
-        squarePieceType[capturedPawnSquare] = PieceType::NONE;
+    movePiece<color>(KING, fromSquare, toSquare);
+    movePiece<color>(ROOK, kingSide ? rank + 7 : rank, kingSide ? rank + 5 : rank + 3);
+}
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+template <ChessEngine::Color color>
+void ChessEngine::makeEnPassant(const int fromSquare, const int toSquare)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
 
-        // Store the zobrist hash of the position in the previous positions array
-        this->previousPositions[this->previousPositionsSize] = this->boardZobristHash;
-        this->previousPositionsSize++;
+    // The captured pawn is behind the target square
+    removePiece<enemyColor>(PAWN, color == Color::WHITE ? toSquare - 8 : toSquare + 8);
+    movePiece<color>(PAWN, fromSquare, toSquare);
 
-        return;
-    }
+    // Reset the halfmove clock on an en passant move
+    this->halfmoveClock = 0;
 }
 
 void ChessEngine::undoMove()
 {
+    // Go back to the network accumulator of the previous position
+    if (this->network.isLoaded())
+        popAccumulator();
+
+    // Go back to the attack info of the previous position
+    this->attackInfoPly--;
+
     // Get the color of the player that made the last move
     const Color colorThatMoved = static_cast<Color>(this->activePlayer ^ 1);
 
@@ -2110,304 +2651,373 @@ void ChessEngine::undoMove()
     undoStack.pop();
 
     // Extract move information
-    uint8_t toSquare = undoHelper.to();
-    uint8_t fromSquare = undoHelper.from();
-    uint64_t toSquareMask = 1ULL << toSquare;
-    uint64_t fromSquareMask = 1ULL << fromSquare;
-    Move::MoveType moveType = undoHelper.moveType();
+    const int toSquare = undoHelper.to();
+    const int fromSquare = undoHelper.from();
+    const PieceType capturedPieceType = static_cast<PieceType>(undoHelper.capturedPieceType());
 
-    if (toSquare == 0 && fromSquare == 0) // Null move
+    // Nothing moved on the board for a null move
+    if (toSquare != 0 || fromSquare != 0)
     {
-        // Castling rights are not affected by null moves
+        if (colorThatMoved == Color::WHITE)
+        {
+            switch (undoHelper.moveType())
+            {
+            case Move::MoveType::NORMAL: undoNormalMove<Color::WHITE>(fromSquare, toSquare, capturedPieceType); break;
+            case Move::MoveType::PROMOTION: undoPromotion<Color::WHITE>(fromSquare, toSquare, capturedPieceType); break;
+            case Move::MoveType::CASTLE: undoCastle<Color::WHITE>(fromSquare, toSquare); break;
+            case Move::MoveType::EN_PASSANT: undoEnPassant<Color::WHITE>(fromSquare, toSquare); break;
+            }
+        }
+        else
+        {
+            switch (undoHelper.moveType())
+            {
+            case Move::MoveType::NORMAL: undoNormalMove<Color::BLACK>(fromSquare, toSquare, capturedPieceType); break;
+            case Move::MoveType::PROMOTION: undoPromotion<Color::BLACK>(fromSquare, toSquare, capturedPieceType); break;
+            case Move::MoveType::CASTLE: undoCastle<Color::BLACK>(fromSquare, toSquare); break;
+            case Move::MoveType::EN_PASSANT: undoEnPassant<Color::BLACK>(fromSquare, toSquare); break;
+            }
+        }
+    }
 
-        // Restore the previous halfmove clock
-        this->halfmoveClock = undoHelper.halfmoveClock();
+    // Restore the previous castling rights
+    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+    castlingRights = undoHelper.castlingRights();
+    boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
 
-        // Restore the previous en passant target bitboard
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        enPassantTargetBitboard = undoHelper.enPassantBitboard();
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+    // Restore the previous en passant target bitboard
+    if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+    enPassantTargetBitboard = undoHelper.enPassantBitboard();
+    if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+    // Restore the previous halfmove clock
+    this->halfmoveClock = undoHelper.halfmoveClock();
 
-        return;
-    }
+    // Change the active player
+    this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
+    this->boardZobristHash ^= this->changePlayerZobristHash;
+}
 
-    if (moveType == Move::MoveType::NORMAL)
-    {
-        // Find moving piece type
-        PieceType movingPieceType = squarePieceType[toSquare];
+template <ChessEngine::Color color>
+void ChessEngine::undoNormalMove(const int fromSquare, const int toSquare, const PieceType capturedPieceType)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
 
-        // Move the piece back
-        pieces[colorThatMoved][movingPieceType] ^= toSquareMask;
-        pieces[colorThatMoved][movingPieceType] ^= fromSquareMask;
-        allPieces[colorThatMoved] ^= toSquareMask;
-        allPieces[colorThatMoved] ^= fromSquareMask;
-        // Updated the zobrist hash for the moving piece
-        boardZobristHash ^= pieceZobristHash[movingPieceType][toSquare];
-        boardZobristHash ^= pieceZobristHash[movingPieceType][fromSquare];
+    // Move the piece back and revert the capture of the enemy piece
+    movePiece<color>(squarePieceType[toSquare], toSquare, fromSquare);
+    if (capturedPieceType != PieceType::NONE)
+        addPiece<enemyColor>(capturedPieceType, toSquare);
+}
 
-        // Find captured piece type
-        PieceType capturedPieceType = static_cast<PieceType>(undoHelper.capturedPieceType());
+template <ChessEngine::Color color>
+void ChessEngine::undoPromotion(const int fromSquare, const int toSquare, const PieceType capturedPieceType)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
 
-        // Revert the capture of the enemy piece
-        if (capturedPieceType != PieceType::NONE)
-        {
-            pieces[colorThatMoved ^ 1][capturedPieceType] ^= toSquareMask;
-            allPieces[colorThatMoved ^ 1] ^= toSquareMask;
+    // Replace the promotion piece by the pawn and revert the capture of the enemy piece
+    removePiece<color>(squarePieceType[toSquare], toSquare);
+    addPiece<color>(PAWN, fromSquare);
+    if (capturedPieceType != PieceType::NONE)
+        addPiece<enemyColor>(capturedPieceType, toSquare);
+}
 
-            // Update the zobrist hash for the captured piece
-            boardZobristHash ^= pieceZobristHash[capturedPieceType][toSquare];
-        }
+template <ChessEngine::Color color>
+void ChessEngine::undoCastle(const int fromSquare, const int toSquare)
+{
+    constexpr int rank = color == Color::WHITE ? 0 : 56;
+    const bool kingSide = toSquare > fromSquare;
 
-        // Update the array that stores piece types for each square
-        squarePieceType[toSquare] = capturedPieceType;
-        squarePieceType[fromSquare] = movingPieceType;
+    // Move the king and the rook back
+    movePiece<color>(KING, toSquare, fromSquare);
+    movePiece<color>(ROOK, kingSide ? rank + 5 : rank + 3, kingSide ? rank + 7 : rank);
+}
 
-        // Restore the previous castling rights
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-        castlingRights = undoHelper.castlingRights();
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+template <ChessEngine::Color color>
+void ChessEngine::undoEnPassant(const int fromSquare, const int toSquare)
+{
+    constexpr Color enemyColor = static_cast<Color>(color ^ 1);
 
-        // Restore the previous en passant target bitboard
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        enPassantTargetBitboard = undoHelper.enPassantBitboard();
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+    // Move the pawn back and put the captured pawn back behind the target square
+    movePiece<color>(PAWN, toSquare, fromSquare);
+    addPiece<enemyColor>(PAWN, color == Color::WHITE ? toSquare - 8 : toSquare + 8);
+}
 
-        // Restore the previous halfmove clock
-        this->halfmoveClock = undoHelper.halfmoveClock();
+unsigned long long ChessEngine::perft(const int depth, const bool bulkCounting)
+{
+    if (depth <= 0)
+        return 1;
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+    // Subtrees reached before through another move order are counted once
+    PerftHashTableEntry* entry = nullptr;
+    if (this->perftHashTable != nullptr && depth >= 2)
+    {
+        const uint64_t key = this->boardZobristHash ^ (depth * PERFT_DEPTH_HASH);
+        entry = &this->perftHashTable[key & (this->perftHashTableSize - 1)];
 
-        return;
+        const PerftHashTableEntry storedEntry = *entry;
+        if (storedEntry.zobristHash() == key && storedEntry.depth() == depth)
+            return storedEntry.nodes();
     }
 
-    if (moveType == Move::MoveType::PROMOTION)
-    {
-        // Find moving piece type
-        PieceType movingPieceType = squarePieceType[toSquare];
+    MoveList movelist = getLegalMoves();
 
-        // Move the piece back
-        pieces[colorThatMoved][movingPieceType] ^= toSquareMask;
-        pieces[colorThatMoved][PAWN] ^= fromSquareMask;
-        allPieces[colorThatMoved] ^= toSquareMask;
-        allPieces[colorThatMoved] ^= fromSquareMask;
-        // Update the zobrist hash for the pawn that promoted
-        boardZobristHash ^= pieceZobristHash[movingPieceType][toSquare];
-        boardZobristHash ^= pieceZobristHash[PAWN][fromSquare];
+    // The generated moves are legal, so the leaves can be counted without making them
+    if (depth == 1 && bulkCounting)
+        return movelist.numberOfMoves;
 
-        // Find captured piece type
-        PieceType capturedPieceType = static_cast<PieceType>(undoHelper.capturedPieceType());
+    unsigned long long result = 0;
 
-        // Revert the capture of the enemy piece
-        if (capturedPieceType != PieceType::NONE)
-        {
-            pieces[colorThatMoved ^ 1][capturedPieceType] ^= toSquareMask;
-            allPieces[colorThatMoved ^ 1] ^= toSquareMask;
+    for (int i = 0; i < movelist.numberOfMoves; i++)
+    {
+        makeMove(movelist.moves[i]);
+        result += perft(depth - 1, bulkCounting);
+        undoMove();
+    }
 
-            // Update the zobrist hash for the captured piece
-            boardZobristHash ^= pieceZobristHash[capturedPieceType][toSquare];
-        }
+    if (entry != nullptr)
+        *entry = PerftHashTableEntry(this->boardZobristHash ^ (depth * PERFT_DEPTH_HASH), depth, result);
 
-        // Update the array that stores piece types for each square
-        squarePieceType[toSquare] = capturedPieceType;
-        squarePieceType[fromSquare] = PieceType::PAWN;
+    return result;
+}
 
-        // Restore the previous castling rights
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-        castlingRights = undoHelper.castlingRights();
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+ChessEngine::PerftResult ChessEngine::parallelPerft(const int depth, const int numberOfThreads, const bool bulkCounting, const int hashSizeInMegabytes)
+{
+    auto start = std::chrono::steady_clock::now();
+    PerftResult result;
+    result.nodes = depth == 0 ? 1 : 0; // Only the root is counted at depth 0, a negative depth has no nodes
+    result.hashSizeInMegabytes = 0;
+    result.hashTableReduced = false;
+
+    // A task is the subtree after a sequence of moves, counted for the root move it starts with
+    struct PerftTask
+    {
+        int rootMove; // The index of the root move
+        std::vector<Move> moves; // The moves from the root to the subtree
+        unsigned long long nodes; // The number of leaf nodes of the subtree
+    };
+
+    MoveList rootMoves = depth <= 0 ? MoveList() : getLegalMoves();
+    std::vector<PerftTask> tasks;
+    for (int i = 0; i < rootMoves.numberOfMoves; i++)
+    {
+        result.divide.push_back(std::make_pair(rootMoves.moves[i], 0ULL));
+        tasks.push_back({ i, { rootMoves.moves[i] }, 0 });
+    }
 
-        // Restore the previous en passant target bitboard
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        enPassantTargetBitboard = undoHelper.enPassantBitboard();
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+    // A few root moves can not keep many threads busy (and their subtrees differ a lot in size), so the tasks are split
+    // a ply deeper until there are plenty of them. Positions without moves before the last ply have no leaf nodes and are dropped
+    const int threads = std::max(numberOfThreads, 1);
+    for (int splitDepth = 1; threads > 1 && tasks.size() < 16 * static_cast<size_t>(threads) && depth - splitDepth > 2; splitDepth++)
+    {
+        std::vector<PerftTask> splitTasks;
+        for (const PerftTask& task : tasks)
+        {
+            for (const Move move : task.moves)
+                makeMove(move);
 
-        // Restore the previous halfmove clock
-        this->halfmoveClock = undoHelper.halfmoveClock();
+            MoveList moves = getLegalMoves();
+            for (int i = 0; i < moves.numberOfMoves; i++)
+            {
+                splitTasks.push_back(task);
+                splitTasks.back().moves.push_back(moves.moves[i]);
+            }
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+            for (size_t i = 0; i < task.moves.size(); i++)
+                undoMove();
+        }
 
-        return;
+        tasks.swap(splitTasks);
     }
 
-    if (moveType == Move::MoveType::CASTLE)
+    // The hash table is shared by all threads (the entries are checked against torn writes like the transposition table entries)
+    size_t hashTableSize = 0;
+    PerftHashTableEntry* hashTable = nullptr;
+    if (hashSizeInMegabytes > 0)
     {
-        uint8_t rookToSquare = 0, rookFromSquare = 0;
-        uint64_t rookToSquareMask = 0, rookFromSquareMask = 0;
+        hashTableSize = 1;
+        while (hashTableSize * 2 * sizeof(PerftHashTableEntry) <= static_cast<size_t>(hashSizeInMegabytes) << 20)
+            hashTableSize *= 2;
 
-        // Identify the castle move
-        switch (toSquare)
+        // The size comes from the user, so a table that can not be allocated is halved until it can (down to 1 MB, then there is none)
+        while (hashTable == nullptr && hashTableSize * sizeof(PerftHashTableEntry) >= 1 << 20)
         {
-        case 2: // White queen side
-            rookFromSquare = 0, rookToSquare = 3;
-            rookFromSquareMask = 1ULL, rookToSquareMask = 1ULL << 3;
-            break;
+            try
+            {
+                hashTable = static_cast<PerftHashTableEntry*>(SystemHelper::allocateInterleaved(hashTableSize * sizeof(PerftHashTableEntry)));
+            }
+            catch (const std::bad_alloc&)
+            {
+                hashTableSize /= 2;
+                result.hashTableReduced = true;
+            }
+        }
 
-        case 6: // White king side
-            rookFromSquare = 7, rookToSquare = 5;
-            rookFromSquareMask = 1ULL << 7, rookToSquareMask = 1ULL << 5;
-            break;
+        if (hashTable == nullptr)
+            hashTableSize = 0;
+    }
+    result.hashSizeInMegabytes = static_cast<int>((hashTableSize * sizeof(PerftHashTableEntry)) >> 20);
 
-        case 58: // Black queen side
-            rookFromSquare = 56, rookToSquare = 59;
-            rookFromSquareMask = 1ULL << 56, rookToSquareMask = 1ULL << 59;
-            break;
+    // Every thread works on its own copy of the board, taking the next task as soon as it is done with one
+    std::vector<std::unique_ptr<ChessEngine>> boards;
+    for (int i = 0; i < threads; i++)
+    {
+        boards.emplace_back(new ChessEngine(*this));
+        boards.back()->perftHashTable = hashTable;
+        boards.back()->perftHashTableSize = hashTableSize;
+    }
 
-        case 62: // Black king side
-            rookFromSquare = 63, rookToSquare = 61;
-            rookFromSquareMask = 1ULL << 63, rookToSquareMask = 1ULL << 61;
-            break;
-        }
+    std::atomic<size_t> nextTask(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&tasks, &nextTask, depth, bulkCounting](ChessEngine* board)
+        {
+            for (size_t task = nextTask++; task < tasks.size(); task = nextTask++)
+            {
+                for (const Move move : tasks[task].moves)
+                    board->makeMove(move);
 
-        // Move the king back
-        pieces[colorThatMoved][KING] ^= toSquareMask;
-        pieces[colorThatMoved][KING] ^= fromSquareMask;
-        allPieces[colorThatMoved] ^= toSquareMask;
-        allPieces[colorThatMoved] ^= fromSquareMask;
-        // Update the zobrist hash for the king that moved
-        boardZobristHash ^= pieceZobristHash[KING][toSquare];
-        boardZobristHash ^= pieceZobristHash[KING][fromSquare];
-
-        // Move the rook back
-        pieces[colorThatMoved][ROOK] ^= rookToSquareMask;
-        pieces[colorThatMoved][ROOK] ^= rookFromSquareMask;
-        allPieces[colorThatMoved] ^= rookToSquareMask;
-        allPieces[colorThatMoved] ^= rookFromSquareMask;
-        // Update the zobrist hash for the rook that moved
-        boardZobristHash ^= pieceZobristHash[ROOK][rookToSquare];
-        boardZobristHash ^= pieceZobristHash[ROOK][rookFromSquare];
-
-        // Update the array that stores piece types for each square
-        squarePieceType[toSquare] = PieceType::NONE;
-        squarePieceType[fromSquare] = PieceType::KING;
-        squarePieceType[rookToSquare] = PieceType::NONE;
-        squarePieceType[rookFromSquare] = PieceType::ROOK;
-
-        // Restore the previous castling rights
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-        castlingRights = undoHelper.castlingRights();
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+                tasks[task].nodes = board->perft(depth - static_cast<int>(tasks[task].moves.size()), bulkCounting);
 
-        // Restore the previous en passant target bitboard
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        enPassantTargetBitboard = undoHelper.enPassantBitboard();
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+                for (size_t j = 0; j < tasks[task].moves.size(); j++)
+                    board->undoMove();
+            }
+        }, boards[i].get());
+    }
 
-        // Restore the previous halfmove clock
-        this->halfmoveClock = undoHelper.halfmoveClock();
+    for (std::thread& worker : workers)
+        worker.join();
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+    SystemHelper::freeLargeMemory(hashTable, hashTableSize * sizeof(PerftHashTableEntry));
 
-        return;
+    for (const PerftTask& task : tasks)
+    {
+        result.divide[task.rootMove].second += task.nodes;
+        result.nodes += task.nodes;
     }
 
-    if (moveType == Move::MoveType::EN_PASSANT)
+    result.timeInMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+ChessEngine::SearchResult ChessEngine::getBestMove()
+{
+    const Color colorToMove = this->activePlayer;
+    SearchResult result = this->iterativeDeepeningSearch(this->getTimeForSearch());
+    storeResultInCache(result);
+
+    // Update the remaining time of the player that searched
+    this->timeRemaining[colorToMove] -= this->timeUsedInMilliseconds;
+
+    return result;
+}
+
+ChessEngine::SearchResult ChessEngine::getBestMove(const int depth)
+{
+    const int searchDepth = std::min(depth, MAX_DEPTH - 1);
+
+    // Answer without searching if the position was already searched deep enough with the same evaluation (a hash collision or a cache
+    // written by another move generator can give a move that is not legal here, then the result is dropped and the position is searched)
+    ResultCache::Result cachedResult;
+    if (this->resultCache.probe(this->boardZobristHash, this->activePlayer, this->castlingRights, getEvaluationSignature(), searchDepth, cachedResult))
     {
-        // Move the pawn back
-        pieces[colorThatMoved][PAWN] ^= toSquareMask;
-        pieces[colorThatMoved][PAWN] ^= fromSquareMask;
-        allPieces[colorThatMoved] ^= toSquareMask;
-        allPieces[colorThatMoved] ^= fromSquareMask;
-        // Update the zobrist hash for the pawn that moved
-        boardZobristHash ^= pieceZobristHash[PAWN][toSquare];
-        boardZobristHash ^= pieceZobristHash[PAWN][fromSquare];
-
-        // Compute the captured pawn coordinates
-        int capturedPawnSquare = 0;
-        uint64_t capturedPawnMask = 0ULL;
-        if (colorThatMoved == Color::WHITE)
+        if (cachedResult.principalVariation.numberOfMoves == 0 || !isValid(cachedResult.principalVariation.moves[0]))
         {
-            // Go one square down
-            capturedPawnSquare = toSquare - 8;
-            capturedPawnMask = 1ULL << capturedPawnSquare;
+            this->resultCache.invalidate(this->boardZobristHash, this->activePlayer, this->castlingRights, getEvaluationSignature());
         }
-        else if (colorThatMoved == Color::BLACK)
+        else
         {
-            // Go one square up
-            capturedPawnSquare = toSquare + 8;
-            capturedPawnMask = 1ULL << capturedPawnSquare;
+            this->resultCache.countHit();
+            this->numberOfNodesVisited = 0;
+            this->depthReached = cachedResult.depth;
+            this->timeUsedInMilliseconds = 0;
+            this->principalVariation = cachedResult.principalVariation;
+            return SearchResult(cachedResult.principalVariation.moves[0], cachedResult.score);
         }
+    }
 
-        // Revert the capture of the enemy pawn
-        pieces[colorThatMoved ^ 1][PAWN] ^= capturedPawnMask;
-        allPieces[colorThatMoved ^ 1] ^= capturedPawnMask;
-        // Update the zobrist hash for the pawn that was captured
-        boardZobristHash ^= pieceZobristHash[PAWN][capturedPawnSquare];
-
-        // Update the array that stores piece types for each square
-        squarePieceType[fromSquare] = PieceType::PAWN;
-        squarePieceType[toSquare] = PieceType::NONE;
-        squarePieceType[capturedPawnSquare] = PieceType::PAWN;
+    SearchResult result = this->iterativeDeepeningSearch(INT_MAX, searchDepth);
+    storeResultInCache(result);
 
-        // Restore the previous castling rights
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
-        castlingRights = undoHelper.castlingRights();
-        boardZobristHash ^= castlingRightsZobristHash[castlingRights & 0xF];
+    return result;
+}
 
-        // Restore the previous en passant target bitboard
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
-        enPassantTargetBitboard = undoHelper.enPassantBitboard();
-        if (enPassantTargetBitboard) boardZobristHash ^= enPassantTargetSquareZobristHash[_tzcnt_u64(enPassantTargetBitboard)];
+bool ChessEngine::setResultCacheFile(const std::string& path)
+{
+    if (path.empty())
+    {
+        this->resultCache.close();
+        return true;
+    }
 
-        // Restore the previous halfmove clock
-        this->halfmoveClock = undoHelper.halfmoveClock();
+    return this->resultCache.open(path, getZobristSignature());
+}
 
-        // Change the active player
-        this->activePlayer = static_cast<Color>(this->activePlayer ^ 1);
-        this->boardZobristHash ^= this->changePlayerZobristHash;
+ResultCache::Statistics ChessEngine::getResultCacheStatistics() const
+{
+    return this->resultCache.getStatistics();
+}
 
+void ChessEngine::storeResultInCache(const SearchResult& result)
+{
+    if (!this->resultCache.isOpen() || result.move.isNull())
         return;
-    }
+
+    ResultCache::Result cachedResult;
+    cachedResult.depth = this->depthReached;
+    cachedResult.score = result.score;
+    cachedResult.principalVariation = this->principalVariation;
+    this->resultCache.store(this->boardZobristHash, this->activePlayer, this->castlingRights, getEvaluationSignature(), cachedResult);
 }
 
-unsigned long long ChessEngine::perft(const int depth)
+Move ChessEngine::getTranspositionTableMove() const
 {
-    if (depth == 0)
-        return 1;
+    const TranspositionTableEntry shallowEntry = shallowTranspositionTable[this->boardZobristHash & (this->shallowTranspositionTableSize - 1)];
+    const TranspositionTableEntry entry = transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)];
 
-    const Color colorToMove = this->activePlayer;
+    // Prefer the main table, which holds the deeper searches
+    if (entry.zobristHash() == this->boardZobristHash)
+        return entry.move();
+    if (shallowEntry.zobristHash() == this->boardZobristHash)
+        return shallowEntry.move();
 
-    uint64_t squaresAttackingKing = getAttacksBitboard(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1));
-    MoveList movelist = squaresAttackingKing ? getPseudolegalMovesInCheck(squaresAttackingKing) : getPseudolegalMoves();
+    return Move();
+}
 
-    /*if (depth == 1)
-    {
-        unsigned long long result = 0;
-        for (int i = 0; i < movelist.numberOfMoves; i++)
-        {
-            makeMove(movelist.moves[i], colorToMove);
-            if (!isAttacked(_tzcnt_u64(pieces[colorToMove][KING])))
-                result++;
-            undoMove(colorToMove);
-        }
-        return result;
-    }*/
-    
-    unsigned long long result = 0;
+void ChessEngine::updatePrincipalVariation(const Move bestMove)
+{
+    this->principalVariation = MoveList();
+    if (bestMove.isNull())
+        return;
 
-    for (int i = 0; i < movelist.numberOfMoves; i++)
+    uint64_t positionsVisited[MAX_PRINCIPAL_VARIATION_LENGTH + 1];
+    positionsVisited[0] = this->boardZobristHash;
+
+    Move move = bestMove;
+    while (this->principalVariation.numberOfMoves < MAX_PRINCIPAL_VARIATION_LENGTH && !move.isNull() && isValid(move))
     {
-        makeMove(movelist.moves[i]);
-        if (!isAttacked(_tzcnt_u64(pieces[colorToMove][KING]), static_cast<Color>(colorToMove ^ 1)))
-            result += perft(depth - 1);
-        undoMove();
+        makeMove(move);
+        this->principalVariation.add(move);
+
+        // Stop at a repeated position (the transposition table moves would go around in circles)
+        bool isRepetition = false;
+        for (int i = 0; i < this->principalVariation.numberOfMoves; i++)
+            if (positionsVisited[i] == this->boardZobristHash)
+                isRepetition = true;
+        positionsVisited[this->principalVariation.numberOfMoves] = this->boardZobristHash;
+        if (isRepetition)
+            break;
+
+        move = getTranspositionTableMove();
     }
 
-    return result;
+    for (int i = 0; i < this->principalVariation.numberOfMoves; i++)
+        undoMove();
 }
 
-ChessEngine::SearchResult ChessEngine::getBestMove()
+MoveList ChessEngine::getPrincipalVariation() const
 {
-    return this->iterativeDeepeningSearch(this->getTimeForSearch());
+    return this->principalVariation;
 }
 
 void ChessEngine::stopCurrentSearch()
@@ -2417,10 +3027,168 @@ void ChessEngine::stopCurrentSearch()
 
 void ChessEngine::clearTranspositionTable()
 {
+    for (int i = 0; i < this->shallowTranspositionTableSize; i++)
+        shallowTranspositionTable[i] = TranspositionTableEntry();
+
+    // The entries of a shared table also belong to the other engine processes, and a loaded snapshot is kept on purpose
+    if (this->transpositionTableStorage != TranspositionTableStorage::PRIVATE_MEMORY)
+        return;
+
     for (int i = 0; i < this->transpositionTableSize; i++)
         transpositionTable[i] = TranspositionTableEntry();
 }
 
+void ChessEngine::setTwoTierTranspositionTable(const bool enabled)
+{
+    this->useShallowTranspositionTable = enabled;
+}
+
+ChessEngine::TranspositionTableStatistics ChessEngine::getTranspositionTableStatistics() const
+{
+    return this->transpositionTableStatistics;
+}
+
+ChessEngine::EvaluationCacheStatistics ChessEngine::getEvaluationCacheStatistics() const
+{
+    return this->evaluationCacheStatistics;
+}
+
+ChessEngine::LazyEvaluationStatistics ChessEngine::getLazyEvaluationStatistics() const
+{
+    return this->lazyEvaluationStatistics;
+}
+
+ChessEngine::TranspositionTableEntry ChessEngine::probeTranspositionTable(const int depth)
+{
+    // Shallow nodes (the vast majority) look in the small table first, which avoids a cache miss in the main table
+    if (this->useShallowTranspositionTable && depth <= SHALLOW_TRANSPOSITION_TABLE_DEPTH)
+    {
+        this->transpositionTableStatistics.shallowProbes++;
+
+        // Both tables count a hit for every entry of the position, and a usable hit if it was searched deep enough
+        const TranspositionTableEntry entry = shallowTranspositionTable[this->boardZobristHash & (this->shallowTranspositionTableSize - 1)];
+        if (entry.zobristHash() == this->boardZobristHash)
+        {
+            this->transpositionTableStatistics.shallowHits++;
+            if (entry.depth() >= depth)
+            {
+                this->transpositionTableStatistics.shallowUsableHits++;
+                return entry;
+            }
+        }
+    }
+
+    this->transpositionTableStatistics.mainProbes++;
+
+    // Copy the entry before checking it, as other processes may write to a shared table
+    const TranspositionTableEntry entry = transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)];
+    if (entry.zobristHash() == this->boardZobristHash)
+    {
+        this->transpositionTableStatistics.mainHits++;
+        if (entry.depth() >= depth)
+            this->transpositionTableStatistics.mainUsableHits++;
+    }
+
+    return entry;
+}
+
+void ChessEngine::storeTranspositionTableEntry(const TranspositionTableEntry& entry)
+{
+    if (this->useShallowTranspositionTable && entry.depth() <= SHALLOW_TRANSPOSITION_TABLE_DEPTH)
+        shallowTranspositionTable[this->boardZobristHash & (this->shallowTranspositionTableSize - 1)] = entry;
+    else
+        transpositionTable[this->boardZobristHash & (this->transpositionTableSize - 1)] = entry;
+}
+
+bool ChessEngine::setSharedTranspositionTable(const std::string& name)
+{
+    if (name == this->transpositionTableName)
+        return true;
+
+    // Go back to a private table
+    if (name.empty())
+    {
+        freeTranspositionTable();
+        allocateTranspositionTable();
+        return true;
+    }
+
+    // Attach to the shared table (entries are validated with their zobrist hash, so no locking is needed)
+    void* sharedTable = SystemHelper::attachSharedMemory(name, this->transpositionTableSize * sizeof(TranspositionTableEntry));
+    if (sharedTable == nullptr)
+        return false;
+
+    freeTranspositionTable();
+    this->transpositionTable = static_cast<TranspositionTableEntry*>(sharedTable);
+    this->transpositionTableStorage = TranspositionTableStorage::SHARED_MEMORY;
+    this->transpositionTableName = name;
+
+    return true;
+}
+
+bool ChessEngine::saveTranspositionTable(const std::string& path) const
+{
+    // A table mapped from the file itself reads its untouched pages from that file, so the file can not be replaced while it is in use
+    if (this->transpositionTableStorage == TranspositionTableStorage::MAPPED_FILE && SystemHelper::isSameFile(path, this->transpositionTableFilePath))
+        return false;
+
+    // Write a new file and only then replace the old one, so other processes mapping the old one keep a complete snapshot
+    const std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    TranspositionTableFileHeader header = {};
+    header.magic = TRANSPOSITION_TABLE_FILE_MAGIC;
+    header.version = TRANSPOSITION_TABLE_FILE_VERSION;
+    header.entrySize = sizeof(TranspositionTableEntry);
+    header.numberOfEntries = this->transpositionTableSize;
+    header.zobristSignature = getZobristSignature();
+    header.evaluationSignature = getEvaluationSignature();
+
+    // The entries are stored exactly as they are in memory, so the file can be mapped back without any conversion
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(this->transpositionTable), static_cast<std::streamsize>(this->transpositionTableSize) * sizeof(TranspositionTableEntry));
+    file.close();
+
+    if (!file || !SystemHelper::replaceFile(temporaryPath, path))
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ChessEngine::loadTranspositionTable(const std::string& path)
+{
+    size_t mappingSize = 0;
+    void* mapping = SystemHelper::mapFile(path, mappingSize);
+    if (mapping == nullptr)
+        return false;
+
+    // Reject files of another format version, table size, set of zobrist hashes or evaluation
+    const TranspositionTableFileHeader* header = static_cast<const TranspositionTableFileHeader*>(mapping);
+    if (mappingSize != sizeof(TranspositionTableFileHeader) + static_cast<size_t>(this->transpositionTableSize) * sizeof(TranspositionTableEntry) ||
+        header->magic != TRANSPOSITION_TABLE_FILE_MAGIC || header->version != TRANSPOSITION_TABLE_FILE_VERSION ||
+        header->entrySize != sizeof(TranspositionTableEntry) || header->numberOfEntries != static_cast<uint64_t>(this->transpositionTableSize) ||
+        header->zobristSignature != getZobristSignature() || header->evaluationSignature != getEvaluationSignature())
+    {
+        SystemHelper::unmapFile(mapping, mappingSize);
+        return false;
+    }
+
+    // Use the mapped entries directly (pages are read in as they are probed, and writes stay private to the process)
+    freeTranspositionTable();
+    this->transpositionTable = reinterpret_cast<TranspositionTableEntry*>(static_cast<char*>(mapping) + sizeof(TranspositionTableFileHeader));
+    this->transpositionTableStorage = TranspositionTableStorage::MAPPED_FILE;
+    this->transpositionTableFileMapping = mapping;
+    this->transpositionTableFileMappingSize = mappingSize;
+    this->transpositionTableFilePath = path;
+
+    return true;
+}
+
 void ChessEngine::clearMoveOrderingTables()
 {
     this->maxHistoryValueReached = false;
@@ -2456,27 +3224,32 @@ ChessEngine::SearchResult ChessEngine::search(const int depth)
     return minimax(INT_MIN, INT_MAX, depth, 1);
 }
 
-ChessEngine::SearchResult ChessEngine::iterativeDeepeningSearch(const int timeLimit)
+ChessEngine::SearchResult ChessEngine::iterativeDeepeningSearch(const int timeLimit, const int maxDepth)
 {
-    this->searchStartTime = std::chrono::high_resolution_clock::now();
+    this->searchStartTime = std::chrono::steady_clock::now();
     this->timeLimitInMilliseconds = timeLimit;
     this->stopSearch = false;
+    this->numberOfNodesVisited = 0;
+    this->depthReached = 0;
+    this->transpositionTableStatistics = TranspositionTableStatistics();
+    this->evaluationCacheStatistics = EvaluationCacheStatistics();
+    this->lazyEvaluationStatistics = LazyEvaluationStatistics();
+    resetAccumulatorStack();
     SearchResult bestMove;
 
     int oldNumberOfNodesVisited = 1;
-    for (int depth = 1; depth < MAX_DEPTH && !this->stopSearch; depth++)
+    for (int depth = 1; depth <= maxDepth && !this->stopSearch; depth++)
     {
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
         if (this->maxHistoryValueReached)
         {
             this->decayHistoryTable(); // Scale the history table down to avoid overflow
             this->maxHistoryValueReached = false; // Reset the flag
         }
-        numberOfNodesVisited = 0;
         this->isAtRoot = true;
         this->clearKillerMoves(); // Clear the killer moves table
         SearchResult result = this->minimax(INT_MIN, INT_MAX, depth, 1);
-        auto stop = std::chrono::high_resolution_clock::now();
+        auto stop = std::chrono::steady_clock::now();
 
         /*if (!this->stopSearch)
         {
@@ -2499,13 +3272,11 @@ ChessEngine::SearchResult ChessEngine::iterativeDeepeningSearch(const int timeLi
         auto searchDuration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
         auto searchTimeLeft = timeLimit - std::chrono::duration_cast<std::chrono::milliseconds>(stop - this->searchStartTime).count();
         if (searchTimeLeft < searchDuration * 2)
-        {
-            this->timeRemaining[this->activePlayer] -= (timeLimit - searchTimeLeft);
-            return bestMove;
-        }
+            break;
     }
 
-    this->timeRemaining[this->activePlayer] -= timeLimit;
+    this->timeUsedInMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->searchStartTime).count());
+    updatePrincipalVariation(bestMove.move);
 
     return bestMove;
 }
@@ -2522,7 +3293,7 @@ int ChessEngine::getDepthReached() const
 
 int ChessEngine::getTimeUsed() const
 {
-    return this->timeLimitInMilliseconds;
+    return this->timeUsedInMilliseconds;
 }
 
 uint64_t ChessEngine::getZobristHash() const
@@ -2530,6 +3301,36 @@ uint64_t ChessEngine::getZobristHash() const
     return this->boardZobristHash;
 }
 
+bool ChessEngine::setNumaNode(const int node)
+{
+    if (node >= SystemHelper::getNumberOfNumaNodes())
+        return false;
+
+    // Pin the calling (search) thread first, so the tables are touched from the node they live on (without a node it may run anywhere again)
+    if (node >= 0 ? !SystemHelper::bindCurrentThreadToNumaNode(node) : !SystemHelper::unbindCurrentThread())
+        return false;
+
+    this->numaNode = node;
+    allocateMoveOrderingTables(node);
+
+    return true;
+}
+
+int ChessEngine::getNumaNode() const
+{
+    return this->numaNode;
+}
+
+bool ChessEngine::setSliderAttacks(const SliderAttacks::Backend backend)
+{
+    return this->sliderAttacks.setBackend(backend);
+}
+
+SliderAttacks::Backend ChessEngine::getSliderAttacks() const
+{
+    return this->sliderAttacks.getBackend();
+}
+
 void ChessEngine::initializeTimeLimits()
 {
     this->timeRemaining[WHITE] = this->timeRemaining[BLACK] = 60000 * 10;
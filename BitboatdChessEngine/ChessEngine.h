@@ -1,7 +1,9 @@
 #pragma once
 #include <cstdint>
+#include <climits>
 #include <string>
 #include <stack>
+#include <vector>
 #include <algorithm>
 #include <chrono>
 #include <random>
@@ -9,6 +11,10 @@
 #include "BitboardGenerator.h"
 #include "Move.h"
 #include "UndoHelper.h"
+#include "SystemHelper.h"
+#include "ResultCache.h"
+#include "NNUE.h"
+#include "SliderAttacks.h"
 
 constexpr int MAX_DEPTH = 64;
 constexpr int MAX_SEE_DEPTH = 16;
@@ -16,6 +22,36 @@ constexpr int MAX_SEE_DEPTH = 16;
 constexpr int NULL_MOVE_DEPTH_THRESHOLD = 4;
 constexpr int NULL_MOVE_DEPTH_REDUCTION = 2;
 
+constexpr uint64_t PERFT_DEPTH_HASH = 0x9E3779B97F4A7C15ULL; // Mixed into the zobrist hash once per ply of depth, so the counts of one position at different depths go to different entries
+
+constexpr int SHALLOW_TRANSPOSITION_TABLE_DEPTH = 2; // Entries searched to this depth or less go to the small (cache resident) transposition table
+
+constexpr int DOUBLED_PAWN_PENALTY = 15; // Penalty for every pawn with another pawn of the same color behind it
+constexpr int ISOLATED_PAWN_PENALTY = 15; // Penalty for a pawn without pawns of the same color on the adjacent files
+constexpr int BACKWARD_PAWN_PENALTY = 10; // Penalty for a pawn whose stop square is attacked by an enemy pawn and can not be defended by a pawn
+constexpr int PASSED_PAWN_BONUS[8] = { 0, 10, 15, 25, 40, 65, 100, 0 }; // Bonus for a passed pawn by the rank it reached (relative to its color)
+
+constexpr int PIECE_PHASE[6] = { 0, 1, 1, 2, 4, 0 }; // Contribution of each piece type to the game phase
+constexpr int TOTAL_PHASE = 24; // The game phase with all pieces on the board (0 when only kings and pawns are left)
+constexpr int BISHOP_PAIR_BONUS = 30; // Bonus for having two or more bishops
+constexpr int KNIGHT_PAWN_ADJUSTMENT = 6; // Knights gain this much for every own pawn above five (and lose it for every pawn below)
+constexpr int ROOK_PAWN_ADJUSTMENT = 12; // Rooks lose this much for every own pawn above five (and gain it for every pawn below)
+constexpr int NORMAL_SCALE_FACTOR = 64; // Scale factor of an endgame the stronger side is expected to convert normally
+constexpr int LAZY_EVALUATION_MARGIN = 250; // Larger than the pawn structure scores seen in practice, so skipping them can not move an evaluation across the search window
+
+// Middle game and end game scores packed in one integer (the end game score in the upper 16 bits), so both are added and subtracted at once
+constexpr int makeScore(const int middlegame, const int endgame) { return static_cast<int>(static_cast<unsigned int>(endgame) << 16) + middlegame; }
+// The middle game part of a packed score
+constexpr int middlegameScore(const int score) { return static_cast<int16_t>(static_cast<uint16_t>(static_cast<unsigned int>(score))); }
+// The end game part of a packed score (rounded, as the middle game part borrows from it when negative)
+constexpr int endgameScore(const int score) { return static_cast<int16_t>(static_cast<uint16_t>((static_cast<unsigned int>(score) + 0x8000) >> 16)); }
+
+constexpr uint64_t ZOBRIST_SEED = 0x7D1E2A4B5C3F9081ULL; // Seed of the zobrist hashes (fixed, so hashes match between processes)
+
+constexpr uint64_t TRANSPOSITION_TABLE_FILE_MAGIC = 0x0031425454494454ULL; // "TDITTB1" marks a transposition table snapshot file
+constexpr uint32_t TRANSPOSITION_TABLE_FILE_VERSION = 2; // Version of the transposition table snapshot file format
+constexpr uint64_t HANDCRAFTED_EVALUATION_VERSION = 1; // Version of the handcrafted evaluation (changed whenever it scores positions differently)
+
 class ChessEngine {
 public:
 	enum PieceType {
@@ -32,14 +68,104 @@ public:
 
 	struct TranspositionTableEntry
 	{
-		uint64_t zobristHash;
-		Move move;
-		int score;
-		int depth;
-		NodeType nodeType;
+		uint64_t key; // Zobrist hash xor data (an entry torn by concurrent writers no longer matches its zobrist hash)
+		uint64_t data; // Bit-packed move, depth, node type and score
+
+		TranspositionTableEntry() : key(0ULL), data(0ULL) {}
+		TranspositionTableEntry(const uint64_t zobrishHash, const Move move, const int score, const int depth, const NodeType nodeType)
+		{
+			data = move.raw() |												// 16 bits for the move
+				(static_cast<uint64_t>(depth & 0xFF) << 16) |					// 8 bits for the depth
+				(static_cast<uint64_t>(nodeType & 0x3) << 24) |					// 2 bits for the node type
+				(static_cast<uint64_t>(static_cast<uint32_t>(score)) << 32);	// 32 bits for the score
+			key = zobrishHash ^ data;
+		}
+
+		// The zobrist hash of the position the entry belongs to
+		inline uint64_t zobristHash() const { return key ^ data; }
+		// The best move found in the position
+		inline Move move() const { return Move(static_cast<uint16_t>(data & 0xFFFF)); }
+		// The depth the position was searched to
+		inline int depth() const { return (data >> 16) & 0xFF; }
+		// The type of the node (exact score, lower bound or upper bound)
+		inline NodeType nodeType() const { return static_cast<NodeType>((data >> 24) & 0x3); }
+		// The score of the position
+		inline int score() const { return static_cast<int32_t>(data >> 32); }
+	};
+
+	struct PerftHashTableEntry
+	{
+		uint64_t key; // Zobrist hash (mixed with the depth) xor data (an entry torn by concurrent writers no longer matches its hash)
+		uint64_t data; // Bit-packed depth and number of leaf nodes
+
+		PerftHashTableEntry() : key(0ULL), data(0ULL) {}
+		PerftHashTableEntry(const uint64_t zobristHash, const int depth, const unsigned long long nodes)
+		{
+			data = static_cast<uint64_t>(depth & 0xFF) |	// 8 bits for the depth
+				(static_cast<uint64_t>(nodes) << 8);		// 56 bits for the number of leaf nodes
+			key = zobristHash ^ data;
+		}
+
+		// The hash of the position and depth the entry belongs to
+		inline uint64_t zobristHash() const { return key ^ data; }
+		// The remaining depth of the subtree
+		inline int depth() const { return data & 0xFF; }
+		// The number of leaf nodes of the subtree
+		inline unsigned long long nodes() const { return data >> 8; }
+	};
+
+	struct TranspositionTableStatistics
+	{
+		unsigned long long shallowProbes; // Probes of the small shallow depth table
+		unsigned long long shallowHits; // Probes of the small shallow depth table that found the position
+		unsigned long long shallowUsableHits; // Probes of the small shallow depth table that found the position searched deep enough
+		unsigned long long mainProbes; // Probes of the main table
+		unsigned long long mainHits; // Probes of the main table that found the position
+		unsigned long long mainUsableHits; // Probes of the main table that found the position searched deep enough
+
+		TranspositionTableStatistics() : shallowProbes(0), shallowHits(0), shallowUsableHits(0), mainProbes(0), mainHits(0), mainUsableHits(0) {}
+	};
+
+	struct EvaluationCacheStatistics
+	{
+		unsigned long long probes; // Evaluations asked for
+		unsigned long long hits; // Evaluations found in the evaluation cache
+
+		EvaluationCacheStatistics() : probes(0), hits(0) {}
+	};
+
+	struct LazyEvaluationStatistics
+	{
+		unsigned long long lazyExits; // Evaluations answered by the material and piece square score alone
+		unsigned long long fullEvaluations; // Evaluations that computed every term
+		unsigned long long lazyCycles; // CPU cycles spent in evaluations that exited early
+		unsigned long long fullCycles; // CPU cycles spent in full evaluations
 
-		TranspositionTableEntry() : zobristHash(0ULL), move(Move()), score(0), depth(0), nodeType(NodeType::EXACT) {}
-		TranspositionTableEntry(const uint64_t zobrishHash, const Move move, const int score, const int depth, const NodeType nodeType) : zobristHash(zobrishHash), move(move), score(score), depth(depth), nodeType(nodeType) {}
+		LazyEvaluationStatistics() : lazyExits(0), fullEvaluations(0), lazyCycles(0), fullCycles(0) {}
+	};
+
+	struct PawnHashTableEntry
+	{
+		uint64_t pawnZobristHash; // The zobrist hash of the pawns the entry belongs to
+		int score; // Score of the pawn structure (doubled, isolated, backward and passed pawns). Positive values favour white
+		uint64_t passedPawns[2]; // Bitboards of the passed pawns of each color
+		uint64_t attackSpans[2]; // Bitboards of the squares the pawns of each color attack now or after advancing
+
+		PawnHashTableEntry() : pawnZobristHash(0ULL), score(0), passedPawns{ 0ULL, 0ULL }, attackSpans{ 0ULL, 0ULL } {}
+	};
+
+	typedef int (ChessEngine::* EndgameEvaluator)(const Color strongSide) const; // Evaluation function specialized for a material signature
+
+	struct MaterialHashTableEntry
+	{
+		uint64_t materialZobristHash; // The zobrist hash of the material signature the entry belongs to
+		int imbalance; // Material imbalance bonus (bishop pair, knights and rooks adjusted by pawns). Positive values favour white
+		uint8_t scaleFactor[2]; // Scale factor applied to the evaluation when the color is ahead (NORMAL_SCALE_FACTOR for no scaling)
+		Color strongSide; // The color the endgame evaluator evaluates for
+		EndgameEvaluator endgameEvaluator; // The specialized evaluation function of the material signature (nullptr if there is none)
+
+		// The hash of a new entry is not 0, which is the hash of the kings only signature
+		MaterialHashTableEntry() : materialZobristHash(~0ULL), imbalance(0), scaleFactor{ NORMAL_SCALE_FACTOR, NORMAL_SCALE_FACTOR }, strongSide(WHITE), endgameEvaluator(nullptr) {}
 	};
 
 	struct SearchResult
@@ -52,6 +178,15 @@ public:
 		SearchResult(const int score) : move(Move()), score(score) {}
 	};
 
+	struct PerftResult
+	{
+		unsigned long long nodes; // The number of leaf nodes
+		long long timeInMicroseconds; // The time the perft took
+		std::vector<std::pair<Move, unsigned long long>> divide; // The number of leaf nodes below each legal move of the position
+		int hashSizeInMegabytes; // The size of the hash table used (0 without one)
+		bool hashTableReduced; // True if the hash table is smaller than asked for, because that much memory could not be allocated
+	};
+
 	ChessEngine(); // Chess engine constructor
 	~ChessEngine(); // Chess engine destructor
 
@@ -63,22 +198,35 @@ public:
 	std::string getSquareNotation(const int square) const; // Get the notation of a square (notation of square 0 is A1)
 
 	Move getMoveFromString(const std::string moveString) const;
-	MoveList getPseudolegalMoves() const; // Get the pseudolegal moves of the active player
-	MoveList getLegalMoves(); // Get the legal moves of the active player
+	MoveList getLegalMoves() const; // Get the legal moves of the active player
 
+	bool givesCheck(const Move move) const; // Check if the given legal move gives check, without making it
 	void makeMove(const Move move); // Make a move on the board
 	void undoMove(); // Undo the last move
 
-	unsigned long long perft(const int depth); // Perft of a given depth
+	unsigned long long perft(const int depth, const bool bulkCounting = true); // Perft of a given depth (with bulk counting the moves of the last ply are counted without making them)
+	PerftResult parallelPerft(const int depth, const int numberOfThreads, const bool bulkCounting = true, const int hashSizeInMegabytes = 0); // Perft of a given depth split by move between board copies running on the given number of threads (with a shared hash table of subtree counts if a size is given)
 	SearchResult getBestMove(); // Get the best move in the current position
+	SearchResult getBestMove(const int depth); // Get the best move in the current position by searching to a fixed depth (no time limit)
 
 	int getNumberOfNodesVisited() const; // Get the number of nodes visited by the last search
 	int getDepthReached() const; // Get the depth reached by the last search
 	int getTimeUsed() const; // Get the time used for the last search
+	MoveList getPrincipalVariation() const; // Get the principal variation found by the last search
 
 	void stopCurrentSearch(); // Stop the current search
 	void clearTranspositionTable(); // Clear the transposition table
+	bool setSharedTranspositionTable(const std::string& name); // Use the named shared memory transposition table, shared with other engine processes (empty name for a private table)
+	bool saveTranspositionTable(const std::string& path) const; // Save a snapshot of the transposition table to the given file
+	bool loadTranspositionTable(const std::string& path); // Map a transposition table snapshot file as the transposition table (stale or incompatible files are rejected)
+	void setTwoTierTranspositionTable(const bool enabled); // Keep shallow depth entries in a small cache resident table instead of the main table
+	TranspositionTableStatistics getTranspositionTableStatistics() const; // Get the transposition table probe statistics of the last search
+	EvaluationCacheStatistics getEvaluationCacheStatistics() const; // Get the evaluation cache statistics of the last search
+	LazyEvaluationStatistics getLazyEvaluationStatistics() const; // Get the lazy evaluation statistics of the last search
 	void clearMoveOrderingTables(); // Clear move ordering tables
+	bool setEvalFile(const std::string& path); // Evaluate with the network in the given file (empty path to go back to the hand written evaluation)
+	bool setResultCacheFile(const std::string& path); // Keep finished search results in the given file, so repeated positions are answered without searching (empty path to stop caching)
+	ResultCache::Statistics getResultCacheStatistics() const; // Get the result cache hit and miss counters
 
 	void setWhiteTime(const int timeInMilliseconds); // Set the remaining time of white (in milliseconds)
 	void setBlackTime(const int timeInMilliseconds); // Set the remaining time of black (in milliseconds)
@@ -87,7 +235,19 @@ public:
 
 	uint64_t getZobristHash() const; // Get the zobrist hash for the current state of the board
 
+	bool setNumaNode(const int node); // Bind the search to the given NUMA node and move the per-thread tables there (-1 for no preference)
+	int getNumaNode() const; // Get the NUMA node the search is bound to (-1 if not bound)
+
+	bool setSliderAttacks(const SliderAttacks::Backend backend); // Look up rook and bishop movement with the given backend (the fastest one on the host is used by default)
+	SliderAttacks::Backend getSliderAttacks() const; // Get the backend rook and bishop movement is looked up with
+
 private:
+	ChessEngine(const ChessEngine& other); // Copy the position of the given engine without the search tables (for threads that only make and generate moves)
+	ChessEngine& operator=(const ChessEngine& other) = delete;
+
+	PerftHashTableEntry* perftHashTable; // Leaf node counts of subtrees by zobrist hash and depth, shared by the board copies of a parallel perft (nullptr if perft does not hash)
+	size_t perftHashTableSize; // The number of entries of the perft hash table (a power of 2)
+
 	Color activePlayer; // The currently active player
 	int halfmoveClock; // The halfmove clock
 	int fullmoveCounter; // The fullmove counter
@@ -106,79 +266,171 @@ private:
 
 	uint8_t castlingRights; // The 4 least significant bits are used to store castling rights
 	uint8_t whiteCastleQueenSide, whiteCastleKingSide, blackCastleQueenSide, blackCastleKingSide; // Values corresponding to each castling right
+	uint8_t castlingRightsKept[64]; // The castling rights kept when a piece moves from or to each square (the king and rook squares lose theirs)
 
 	uint64_t enPassantTargetBitboard; // Bitboard containing the squares that can be attacked by an "en passant" move
 
-	uint64_t squaresBetween[64][64]; // Bitboards containing the squares between two other squares (if they are on the same line or diagonal)
-
-	uint64_t pawnPushes[2][64], pawnAttacks[2][64]; // Bitboards for pawn movement
-	uint64_t knightMovement[64]; // Bitboards for knight movement
-	uint64_t kingMovement[64]; // Bitboards for king movement
-
-	uint64_t rookOccupancyMask[64]; // Bitboards for rook occupancy masks
-	uint64_t* rookMovement; // Bitboards for rook movement
-	int rookSquareOffset[64]; // Offset for each square in the rook movement array
-
-	uint64_t bishopOccupancyMask[64]; // Bitboards for bishop occupancy masks
-	uint64_t* bishopMovement; // Bitboards for bishop movement
-	int bishopSquareOffset[64]; // Offset for each square in the bishop movement array
+	SliderAttacks sliderAttacks; // Rook and bishop movement for any occupancy (the other movement tables are shared by the process, see AttackTables)
 
 	PieceType promotionPieceToPieceType[4]; // Get the corresponding piece type from an encoded promotion piece
 
-	uint64_t pieceZobristHash[6][64]; // Zobrist hash for each piece type on every square of the board
+	uint64_t pieceZobristHash[2][6][64]; // Zobrist hash for each piece color and type on every square of the board
 	uint64_t castlingRightsZobristHash[16]; // Zobrist hash for each possible combination of castling rights
 	uint64_t enPassantTargetSquareZobristHash[64]; // Zobrist hash for each en passant target square
 	uint64_t changePlayerZobristHash; // Zobrist hash for changing the active player
 	uint64_t boardZobristHash; // The zobrist hash for the current state of the board
+	uint64_t computeZobristHash() const; // Compute the zobrist hash of the current state of the board from scratch
+	int pieceSquareValue[2][6][64]; // Packed middle game and end game value of each piece color and type on every square (negative for black)
+	int pieceSquareScore; // The packed sum of the values of all pieces on the board. Positive values favour white
+	int computePieceSquareScore() const; // Compute the sum of the values of all pieces on the board from scratch
+	int gamePhase; // The game phase (TOTAL_PHASE with all pieces on the board, 0 with only kings and pawns)
+	int computeGamePhase() const; // Compute the game phase from scratch
+
+	uint64_t pawnZobristHash; // The zobrist hash of the pawns on the board (pawn structure)
+	uint64_t computePawnZobristHash() const; // Compute the zobrist hash of the pawns on the board from scratch
+
+	uint64_t pieceCountZobristHash[2][6][64]; // Zobrist hash for each piece color and type and every count of such pieces (the material signature is the xor of the hashes of counts below the piece count)
+	uint64_t materialZobristHash; // The zobrist hash of the material on the board (material signature)
+	uint64_t computeMaterialZobristHash() const; // Compute the zobrist hash of the material on the board from scratch
+
+	const int materialHashTableSize = 1 << 13; // The size of the material hash table
+	MaterialHashTableEntry* materialHashTable; // Material dependent evaluation data by material zobrist hash
+	const MaterialHashTableEntry& probeMaterialHashTable() const; // Get the material data of the current position, computing it if it is not stored
+	void evaluateMaterial(MaterialHashTableEntry& entry) const; // Compute the material data of the current position into the entry
+	int evaluateDraw(const Color strongSide) const; // Endgame evaluator for material that can not win for either side
+	int evaluateKXK(const Color strongSide) const; // Endgame evaluator for a lone king against mating material (drive the king to the edge)
+
+	const int pawnHashTableSize = 1 << 14; // The size of the pawn hash table (48 byte entries, 768 KB)
+	PawnHashTableEntry* pawnHashTable; // Pawn structure evaluations by pawn zobrist hash (the pawns rarely change, so most probes hit)
+	const PawnHashTableEntry& probePawnHashTable() const; // Get the pawn structure evaluation of the current position, evaluating it if it is not stored
+	void evaluatePawnStructure(PawnHashTableEntry& entry) const; // Evaluate the pawn structure of the current position into the entry
 
 	const int transpositionTableSize = 1 << 25; // The size of the transposition table
-	TranspositionTableEntry* transpositionTable; // Transposition table
+	enum TranspositionTableStorage {
+		PRIVATE_MEMORY, SHARED_MEMORY, MAPPED_FILE
+	};
+
+	struct TranspositionTableFileHeader
+	{
+		uint64_t magic; // Always TRANSPOSITION_TABLE_FILE_MAGIC
+		uint32_t version; // The version of the file format
+		uint32_t entrySize; // The size of a transposition table entry in bytes
+		uint64_t numberOfEntries; // The number of entries following the header
+		uint64_t zobristSignature; // Signature of the zobrist hashes the entries were stored with
+		uint64_t evaluationSignature; // Signature of the evaluation the scores of the entries come from
+		uint64_t reserved[3]; // Padding that keeps the entries 64 bytes aligned
+	};
 
-	int historyTable[2][64][64]; // Table used for history heuristic
+	TranspositionTableEntry* transpositionTable; // Transposition table
+	TranspositionTableStorage transpositionTableStorage; // The memory backing the transposition table
+	std::string transpositionTableName; // The name of the shared memory transposition table (empty if the table is not shared)
+	void* transpositionTableFileMapping; // The mapping of the snapshot file backing the transposition table (header included)
+	size_t transpositionTableFileMappingSize; // The size of the snapshot file mapping
+	std::string transpositionTableFilePath; // The path of the snapshot file backing the transposition table (empty if no file is mapped)
+	void allocateTranspositionTable(); // Allocate a private transposition table
+	void freeTranspositionTable(); // Free or detach the transposition table
+	uint64_t getZobristSignature() const; // Get a signature of the zobrist hashes (used to reject snapshots made with different hashes)
+	uint64_t getEvaluationSignature() const; // Get a signature of the evaluation in use (used to reject stored scores of another evaluation)
+
+	const int shallowTranspositionTableSize = 1 << 15; // The size of the shallow depth transposition table (512 KB, small enough to stay in L2)
+	TranspositionTableEntry* shallowTranspositionTable; // Transposition table for entries searched to a shallow depth
+	bool useShallowTranspositionTable; // True if shallow depth entries are kept in the shallow depth table
+	TranspositionTableStatistics transpositionTableStatistics; // Probe statistics of the current search
+	TranspositionTableEntry probeTranspositionTable(const int depth); // Get the entry of the current position, looking in the table that holds entries of the given depth first
+	void storeTranspositionTableEntry(const TranspositionTableEntry& entry); // Store an entry of the current position in the table matching its depth
+	Move getTranspositionTableMove() const; // Get the move stored for the current position in either table (null move if the position is not stored)
+
+	ResultCache resultCache; // Results of finished searches
+	MoveList principalVariation; // The principal variation found by the last search
+	void updatePrincipalVariation(const Move bestMove); // Get the principal variation by following the transposition table moves after the best move
+	void storeResultInCache(const SearchResult& result); // Store the result of the last search in the result cache
+
+	int numaNode; // The NUMA node the search thread is bound to (-1 if not bound)
+	void allocateMoveOrderingTables(const int node); // Allocate the history and killer tables on the given NUMA node (keeping their contents)
+	void freeMoveOrderingTables(); // Free the history and killer tables
+
+	int (*historyTable)[64][64]; // Table used for history heuristic (indexed [color][from][to])
 	bool maxHistoryValueReached; // Flag set when the max history value is reached
 	void decayHistoryTable(); // Scale down the values in the history heuristic (used to avoid overflow)
 	void updateHistoryTable(const Color color, const Move move, const int depth); // Update the history table for the given color, move and depth
 
-	Move killerMoves[MAX_DEPTH + 1][2]; // Table that stores killer moves by ply
+	Move (*killerMoves)[2]; // Table that stores killer moves by ply (MAX_DEPTH + 1 plies)
 	void updateKillerMoves(const Move move, const int ply); // Update the killer moves table
 	void clearKillerMoves(); // Clear the killer moves table
 
+	struct AttackInfo
+	{
+		int ply; // The ply of the position the checkers and pins belong to (INT_MIN when not computed)
+		int attackMapsPly; // The ply of the position the attack maps belong to (INT_MIN when not computed)
+		int checkSquaresPly; // The ply of the position the check squares belong to (INT_MIN when not computed)
+		uint64_t checkers; // Bitboard of the enemy pieces giving check to the king of the side to move
+		uint64_t pinned; // Bitboard of the pieces of the side to move pinned to their king
+		uint64_t attackedSquares[2]; // Bitboards of the squares attacked by each color (the enemy sliders see through the king of the side to move)
+		uint64_t checkSquares[6]; // Bitboards of the squares each piece type of the side to move would give check from
+		uint64_t discoveredCheckers; // Bitboard of the pieces of the side to move that are the only piece between one of its sliders and the enemy king (moving them off the line gives check)
+		uint64_t pieceAttacks[64]; // Bitboard of the squares attacked by the piece on each square
+		uint64_t xrayAttackers[64]; // X-ray attackers of both colors to each square (filled when static exchange evaluation asks for the square)
+		uint64_t xrayAttackersComputed; // Bitboard of the squares with computed x-ray attackers
+	};
+
+	const int attackInfoStackSize = 128; // The number of plies the attack info stack holds (a power of 2, deeper plies reuse the entries)
+	AttackInfo* attackInfoStack; // Attack info of the positions on the way from the last loaded position to the current position
+	int attackInfoPly; // The ply of the current position
+	const AttackInfo& getAttackInfo() const; // Get the checkers and pins of the current position, computing them if they are not computed yet
+	const AttackInfo& getAttackMaps() const; // Get the attack info of the current position with the attacked squares and piece attacks computed
+	const AttackInfo& getCheckSquares() const; // Get the attack info of the current position with the check squares and discovered checkers computed
+	void computeCheckersAndPins(AttackInfo& info) const; // Compute the checkers and the pinned pieces of the current position into the attack info
+	void computeAttackMaps(AttackInfo& info) const; // Compute the squares attacked by each color and by each piece of the current position into the attack info
+	void computeCheckSquares(AttackInfo& info) const; // Compute the squares giving check to the enemy king and the discovered check candidates of the current position into the attack info
+	void clearAttackInfoStack(); // Forget all attack info (the board was changed without making a move)
+	bool isLegal(const Move move) const; // Check if the given pseudolegal move leaves the king of the side to move safe (tested before the move is made)
+	bool isLegalEnPassant(const int fromSquare, const int toSquare) const; // Check if the en passant capture between the given squares leaves the king of the side to move safe
+
 	uint64_t getXrayAttacksToSquare(const int square, const Color color) const; // Get all x-ray attacks of the given color to the given square
+	uint64_t getXrayAttackers(const int square) const; // Get the x-ray attackers of both colors to the given square from the attack info of the current position
 	int SEE(const int square, const Color color) const; // Static exchange evaluation for the given square and color
 	int recursiveSEE(const int square, const Color color) const; // Recursive static exchange evaluation for the given square and color
 
     std::stack<UndoHelper> undoStack; // Stack information about every move (for undo purposes)
 
+	// Make and undo moves of each type for each color (makeMove and undoMove update the state every move changes)
+	template <Color color> void movePiece(const PieceType pieceType, const int fromSquare, const int toSquare); // Move a piece, updating the bitboards, hashes and scores
+	template <Color color> void removePiece(const PieceType pieceType, const int square); // Remove a piece, updating the bitboards, hashes, scores and the game phase
+	template <Color color> void addPiece(const PieceType pieceType, const int square); // Add a piece, updating the bitboards, hashes, scores and the game phase
+	template <Color color> void makeNormalMove(const int fromSquare, const int toSquare); // Make a normal move or capture (sets the en passant square of a double push)
+	template <Color color> void makePromotion(const int fromSquare, const int toSquare, const PieceType promotionType); // Make a pawn promotion
+	template <Color color> void makeCastle(const int fromSquare, const int toSquare); // Move the king and the rook of a castle
+	template <Color color> void makeEnPassant(const int fromSquare, const int toSquare); // Make an en passant capture
+	template <Color color> void undoNormalMove(const int fromSquare, const int toSquare, const PieceType capturedPieceType); // Undo a normal move or capture
+	template <Color color> void undoPromotion(const int fromSquare, const int toSquare, const PieceType capturedPieceType); // Undo a pawn promotion
+	template <Color color> void undoCastle(const int fromSquare, const int toSquare); // Move the king and the rook of a castle back
+	template <Color color> void undoEnPassant(const int fromSquare, const int toSquare); // Undo an en passant capture
+
     void initializeBitboards(); // Initialize bitboards with the classic chess setup
     void initializeSquarePieceTypeArray(); // Initialize the array that stores piece type for every square with the classic chess setup
     void initializePromotionPieceToPieceTypeArray(); // Initialize the array that stores the corresponding piece type for every promotion type
     void initializePositionSpecialStatistics(); // Initialize castling rights, en passant squares, number of moves
 	void initializeZobristHash(); // Initialize zobrist hashes
+	void initializePieceSquareValues(); // Initialize the value of every piece on every square
 	void initializeMoveOrderingTables(); // Initialize the tables used for move ordering
 
-    void initializeSquaresBetweenBitboards(); // Initialize the bitboards containing the squares between two other squares
-
-    void initializePawnMovesetBitboards(); // Initialize pawn push and attack bitboards
-    void initializeKnightMovesetBitboards(); // Initialize knight moveset bitboards
-    void initializeKingMovesetBitboards(); // Initialize king moveset bitboards
-
-    void initializeRookOccupancyMasks(); // Initialize rook occupancy masks
-    void initializeRookMovesetBitboards(); // Initialize rook moveset bitboards
-
-    void initializeBishopOccupancyMasks(); // Initialize bishop occupancy masks
-    void initializeBishopMovesetBitboards(); // Initialize bishop moveset bitboards
-
-    void addPawnMoves(MoveList& moveList, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the pawn moves of the active player (within the mask) to the move list
-    void addKnightMoves(MoveList& moveList, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the knight moves of the active player (within the mask) to the move list
-    void addKingMoves(MoveList& movelist) const; // Add all the king moves of the active player to the move list
-    void addRookMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the rook moves of the active player (within the mask) to the move list
-    void addBishopMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the bishop moves of the active player (within the mask) to the move list
-    void addQueenMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the queen moves of the active player (within the mask) to the move list
+	template <Color color>
+	void addPawnMoves(MoveList& moveList, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the legal pawn moves of the active player (within the mask) to the move list
+	template <Color color>
+	void addKnightMoves(MoveList& moveList, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the legal knight moves of the active player (within the mask) to the move list
+	template <Color color>
+	void addKingMoves(MoveList& movelist) const; // Add all the legal king moves of the active player to the move list
+	template <Color color>
+	void addRookMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the legal rook moves of the active player (within the mask) to the move list
+	template <Color color>
+	void addBishopMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the legal bishop moves of the active player (within the mask) to the move list
+	template <Color color>
+	void addQueenMoves(MoveList& movelist, const uint64_t mask = 0xFFFFFFFFFFFFFFFF) const; // Add all the legal queen moves of the active player (within the mask) to the move list
+	template <Color color>
+	MoveList generateLegalMoves() const; // Generate the legal moves of the given color (the active player)
 
     bool isAttacked(const int square, const Color color) const; // Returns true if the given square is attacked by the given color, false otherwise
-	uint64_t getAttacksBitboard(const int square, const Color color) const; // Returns the number of attacks the given color has on the given square
-
-	MoveList getPseudolegalMovesInCheck(const uint64_t attackingSquares) const; // Get the pseudolegal moves of the active player when in check (checked by the attacking squares)
+	bool isAttacked(const int square, const Color color, const uint64_t occupancy) const; // Returns true if the given square is attacked by the given color when the given squares are occupied
 
 	bool isValid(const Move move); // Check if the given move is valid in the current state of the board
 
@@ -186,17 +438,45 @@ private:
 	void sortMoves(MoveList& movelist) const; // Sort the move list using MVV-LVA
 	int assignScore(const Move move) const;
 
-	int evaluate() const; // Compute an evaluation of the current state of the board. Positive values favour white, negative values favour black.
+	int evaluate(const int alpha, const int beta); // Get the evaluation of the current state of the board from the evaluation cache, computing it if it is not cached (a score far outside the window is only estimated)
+	int computeEvaluation() const; // Compute an evaluation of the current state of the board. Positive values favour white, negative values favour black.
+	int computeLazyEvaluation(const MaterialHashTableEntry& material) const; // Compute the cheap part of the evaluation (tapered material and piece square score, material imbalance)
+
+	struct EvaluationCacheEntry
+	{
+		uint64_t zobristHash; // The zobrist hash of the position
+		int score; // The evaluation of the position
+	};
+
+	NNUE network; // The evaluation network (used when loaded)
+	const int accumulatorStackSize = 256; // The number of plies the accumulator stack holds
+	Accumulator* accumulatorStack; // Network accumulators of the positions on the way from the search root to the current position
+	AccumulatorUpdate* accumulatorUpdates; // The pieces changed by the move leading to each position of the accumulator stack
+	int accumulatorPly; // The index of the accumulator of the current position
+	int accumulatorOverflow; // The number of moves made past the end of the accumulator stack
+	void pushAccumulator(const Move move); // Record the pieces the given move changes before it is made (the accumulator is updated when it is needed)
+	void updateAccumulator(); // Bring the accumulator of the current position up to date
+	void popAccumulator(); // Go back to the accumulator of the position before the last move
+	void resetAccumulatorStack(); // Make the accumulator of the current position the bottom of the stack
+	void clearAccumulatorStack(); // Forget all accumulators (the accumulator of the current position is refreshed from the board when it is needed)
+	int evaluateNetwork(); // Evaluate the current position with the network
+
+	void clearEvaluationCache(); // Clear the evaluation cache
+	const int evaluationCacheSize = 1 << 16; // The size of the evaluation cache (1 MB)
+	EvaluationCacheEntry* evaluationCache; // Evaluations of recently evaluated positions by zobrist hash
+	EvaluationCacheStatistics evaluationCacheStatistics; // Evaluation cache statistics of the current search
+	LazyEvaluationStatistics lazyEvaluationStatistics; // Lazy evaluation statistics of the current search
 	
 	int currentPly; // The ply the search is currently at
 	bool isAtRoot; // True if the search is at root level, false otherwise
 	int numberOfNodesVisited; // Number of nodes visited by the last search
 	int depthReached; // Depth reached by the last search
+	int timeUsedInMilliseconds; // Time used by the last search
 	SearchResult minimax(int alpha, int beta, const int depth, const int ply); // Minimax algorithm with alpha beta pruning
 	int getTimeForSearch() const;
 
 	SearchResult search(const int depth); // Search for the best move of the active player by going to the given depth in the game tree
-	SearchResult iterativeDeepeningSearch(const int timeLimit); // Ssearch for the best move of the active player within the time limit (in milliseconds)
+	SearchResult iterativeDeepeningSearch(const int timeLimit, const int maxDepth = MAX_DEPTH - 1); // Ssearch for the best move of the active player within the time limit (in milliseconds) and the depth limit
 	std::chrono::steady_clock::time_point searchStartTime; // The time the search started
 	int timeLimitInMilliseconds; // The time allocated to the search in milliseconds
 	bool stopSearch; // Flag set to true when the time limit is exceeded
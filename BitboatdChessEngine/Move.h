@@ -37,6 +37,9 @@ public:
     // UCI Constructor
     Move(const std::string moveString);
 
+    // Raw data constructor
+    explicit Move(const uint16_t moveData) : moveData(moveData) {}
+
     // The position from which the piece moves
     inline int from() const { return moveData & 0x3F; }
     // The position the piece moves to
@@ -0,0 +1,267 @@
+#include "NNUE.h"
+#include "SystemHelper.h"
+#include <fstream>
+#include <utility>
+#include <cstring>
+#include <immintrin.h>
+
+// The network file named by EMBEDDED_NETWORK_FILE at build time (for example -DEMBEDDED_NETWORK_FILE=\"default.nnue\") is linked into the binary,
+// aligned like a mapped file so the weights are used in place. MSVC can not include binary files, there the file is linked as the RCDATA
+// resource EMBEDDED_NETWORK of a resource script instead
+#if defined(EMBEDDED_NETWORK_FILE) && defined(__linux__)
+__asm__(
+	".section .rodata\n"
+	".balign 64\n"
+	".global embeddedNetworkBegin\n"
+	"embeddedNetworkBegin:\n"
+	".incbin \"" EMBEDDED_NETWORK_FILE "\"\n"
+	".global embeddedNetworkEnd\n"
+	"embeddedNetworkEnd:\n"
+	".previous\n");
+
+extern "C" const char embeddedNetworkBegin[];
+extern "C" const char embeddedNetworkEnd[];
+#endif
+
+NNUE::NNUE()
+{
+	this->storage = Storage::NONE;
+	this->memory = nullptr;
+	this->memorySize = 0;
+	this->featureWeights = nullptr;
+	this->featureBiases = nullptr;
+	this->outputWeights = nullptr;
+	this->outputBias = 0;
+	this->signature = 0;
+	this->kernels = &NNUEKernels::getBest();
+}
+
+NNUE::~NNUE()
+{
+	unload();
+}
+
+size_t NNUE::getParametersSize()
+{
+	// Every block is a multiple of 64 bytes, the output bias is padded to 64 bytes
+	return sizeof(int16_t) * (static_cast<size_t>(NNUE_INPUT_SIZE) * NNUE_HIDDEN_SIZE + NNUE_HIDDEN_SIZE + 2 * NNUE_HIDDEN_SIZE) + 64;
+}
+
+const void* NNUE::getEmbeddedNetwork(size_t& size)
+{
+#if defined(EMBEDDED_NETWORK_FILE) && defined(__linux__)
+	size = embeddedNetworkEnd - embeddedNetworkBegin;
+	return embeddedNetworkBegin;
+#elif defined(EMBEDDED_NETWORK_FILE)
+	return SystemHelper::getResource("EMBEDDED_NETWORK", size);
+#else
+	size = 0;
+	return nullptr;
+#endif
+}
+
+bool NNUE::hasEmbeddedNetwork()
+{
+	size_t size = 0;
+	return getEmbeddedNetwork(size) != nullptr;
+}
+
+bool NNUE::useImage(const void* image, const size_t size)
+{
+	// Reject files of another format version or network size
+	const FileHeader* header = static_cast<const FileHeader*>(image);
+	if (size != sizeof(FileHeader) + getParametersSize() || header->magic != NNUE_FILE_MAGIC || header->version != NNUE_FILE_VERSION ||
+		header->inputSize != NNUE_INPUT_SIZE || header->hiddenSize != NNUE_HIDDEN_SIZE)
+		return false;
+
+	// The file holds the parameters exactly as the kernels use them, nothing is transformed
+	const int16_t* parameters = reinterpret_cast<const int16_t*>(header + 1);
+	this->featureWeights = parameters;
+	this->featureBiases = this->featureWeights + NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE;
+	this->outputWeights = this->featureBiases + NNUE_HIDDEN_SIZE;
+	memcpy(&this->outputBias, this->outputWeights + 2 * NNUE_HIDDEN_SIZE, sizeof(this->outputBias));
+
+	// Multiply and xor hash of the parameters (they are a multiple of 64 bytes)
+	const uint64_t* words = reinterpret_cast<const uint64_t*>(parameters);
+	this->signature = 0x9E3779B97F4A7C15ULL;
+	for (size_t i = 0; i < getParametersSize() / sizeof(uint64_t); i++)
+	{
+		this->signature = (this->signature ^ words[i]) * 0xFF51AFD7ED558CCDULL;
+		this->signature ^= this->signature >> 32;
+	}
+
+	return true;
+}
+
+bool NNUE::load(const std::string& path)
+{
+	NNUE network;
+
+	if (path == NNUE_EMBEDDED_NETWORK)
+	{
+		size_t size = 0;
+		const void* image = getEmbeddedNetwork(size);
+		if (image == nullptr)
+			return false;
+
+		// The kernels load the weights 64 bytes aligned, resources are only aligned to a few bytes and get copied
+		if (reinterpret_cast<uintptr_t>(image) % 64 != 0)
+		{
+			network.memory = _mm_malloc(size, 64);
+			if (network.memory == nullptr)
+				return false;
+			memcpy(network.memory, image, size);
+			image = network.memory;
+			network.storage = Storage::COPY;
+		}
+		else
+		{
+			network.storage = Storage::EMBEDDED;
+		}
+
+		if (!network.useImage(image, size))
+			return false;
+	}
+	else
+	{
+		// Mapped pages are only read when they are used and are shared by all engine processes using the same file
+		network.memory = SystemHelper::mapFile(path, network.memorySize);
+		if (network.memory == nullptr)
+			return false;
+		network.storage = Storage::MAPPED_FILE;
+
+		if (!network.useImage(network.memory, network.memorySize))
+			return false;
+	}
+
+	// Take over the new network (the temporary releases the old one)
+	std::swap(this->storage, network.storage);
+	std::swap(this->memory, network.memory);
+	std::swap(this->memorySize, network.memorySize);
+	std::swap(this->featureWeights, network.featureWeights);
+	std::swap(this->featureBiases, network.featureBiases);
+	std::swap(this->outputWeights, network.outputWeights);
+	std::swap(this->outputBias, network.outputBias);
+	std::swap(this->signature, network.signature);
+
+	return true;
+}
+
+void NNUE::unload()
+{
+	if (this->storage == Storage::MAPPED_FILE)
+		SystemHelper::unmapFile(this->memory, this->memorySize);
+	else if (this->storage == Storage::COPY)
+		_mm_free(this->memory);
+
+	this->storage = Storage::NONE;
+	this->memory = nullptr;
+	this->memorySize = 0;
+	this->featureWeights = nullptr;
+	this->featureBiases = nullptr;
+	this->outputWeights = nullptr;
+	this->outputBias = 0;
+	this->signature = 0;
+}
+
+bool NNUE::isLoaded() const
+{
+	return this->storage != Storage::NONE;
+}
+
+uint64_t NNUE::getSignature() const
+{
+	return this->signature;
+}
+
+bool NNUE::save(const std::string& path, const int16_t* featureWeights, const int16_t* featureBiases, const int16_t* outputWeights, const int32_t outputBias)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	FileHeader header = {};
+	header.magic = NNUE_FILE_MAGIC;
+	header.version = NNUE_FILE_VERSION;
+	header.inputSize = NNUE_INPUT_SIZE;
+	header.hiddenSize = NNUE_HIDDEN_SIZE;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	file.write(reinterpret_cast<const char*>(featureWeights), sizeof(int16_t) * NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE);
+	file.write(reinterpret_cast<const char*>(featureBiases), sizeof(int16_t) * NNUE_HIDDEN_SIZE);
+	file.write(reinterpret_cast<const char*>(outputWeights), sizeof(int16_t) * 2 * NNUE_HIDDEN_SIZE);
+
+	// The output bias is padded to 64 bytes
+	char padding[64] = {};
+	memcpy(padding, &outputBias, sizeof(outputBias));
+	file.write(padding, sizeof(padding));
+
+	return static_cast<bool>(file);
+}
+
+const NNUEKernels& NNUE::getKernels() const
+{
+	return *this->kernels;
+}
+
+void NNUE::setKernels(const NNUEKernels& kernels)
+{
+	this->kernels = &kernels;
+}
+
+void NNUE::refresh(Accumulator& accumulator, const uint64_t pieces[2][6]) const
+{
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		const int16_t* rows[64];
+		int numberOfRows = 0;
+
+		for (int color = 0; color < 2; color++)
+			for (int type = 0; type < 6; type++)
+			{
+				uint64_t bitboard = pieces[color][type];
+
+				while (bitboard)
+				{
+					rows[numberOfRows++] = this->featureWeights + featureIndex(perspective, color, type, _tzcnt_u64(bitboard)) * NNUE_HIDDEN_SIZE;
+					bitboard &= bitboard - 1;
+				}
+			}
+
+		this->kernels->accumulate(accumulator.values[perspective], this->featureBiases, rows, numberOfRows);
+	}
+
+	accumulator.computed = true;
+}
+
+void NNUE::update(const Accumulator& previous, Accumulator& accumulator, const AccumulatorUpdate& update) const
+{
+	if (update.numberOfRemoved == 0)
+	{
+		accumulator = previous;
+		return;
+	}
+
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		const int16_t* removedRows[2];
+		const int16_t* addedRows[2];
+		for (int j = 0; j < update.numberOfRemoved; j++)
+			removedRows[j] = this->featureWeights + featureIndex(perspective, update.removed[j][0], update.removed[j][1], update.removed[j][2]) * NNUE_HIDDEN_SIZE;
+		for (int j = 0; j < update.numberOfAdded; j++)
+			addedRows[j] = this->featureWeights + featureIndex(perspective, update.added[j][0], update.added[j][1], update.added[j][2]) * NNUE_HIDDEN_SIZE;
+
+		// Every other move removes and adds at least one piece, all rows are applied in one pass over the accumulator
+		this->kernels->update(previous.values[perspective], accumulator.values[perspective], removedRows, update.numberOfRemoved, addedRows, update.numberOfAdded);
+	}
+
+	accumulator.computed = true;
+}
+
+int NNUE::evaluate(const Accumulator& accumulator, const int sideToMove) const
+{
+	// Clipped ReLU of both accumulators followed by the output layer
+	const int32_t sum = this->kernels->output(accumulator.values[sideToMove], accumulator.values[sideToMove ^ 1], this->outputWeights);
+
+	return static_cast<int>((static_cast<int64_t>(sum) + this->outputBias) * NNUE_SCALE / (NNUE_QA * NNUE_QB));
+}
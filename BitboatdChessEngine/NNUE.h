@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "NNUEKernels.h"
+
+constexpr int NNUE_INPUT_SIZE = 768; // One input for each piece color and type on every square
+constexpr int NNUE_HIDDEN_SIZE = 256; // The size of the accumulator of each perspective
+
+constexpr int NNUE_QA = 255; // Quantization of the feature transformer (an accumulator value of NNUE_QA stands for 1.0)
+constexpr int NNUE_QB = 64; // Quantization of the output weights
+constexpr int NNUE_SCALE = 400; // Centipawns of a network output of 1.0
+
+constexpr uint64_t NNUE_FILE_MAGIC = 0x3145554E4E494454ULL; // "TDINNUE1" marks a network file
+constexpr uint32_t NNUE_FILE_VERSION = 1; // Version of the network file format
+
+const std::string NNUE_EMBEDDED_NETWORK = "<embedded>"; // The file name that loads the network built into the binary
+
+// The feature transformer output of a position, seen from both sides (first index for the perspective)
+struct alignas(64) Accumulator
+{
+	int16_t values[2][NNUE_HIDDEN_SIZE];
+	bool computed; // False if the values do not match the position and have to be refreshed from the board
+};
+
+// The pieces a move removes from and adds to the board (captures, promotions and castling change up to two of each)
+struct AccumulatorUpdate
+{
+	uint8_t numberOfRemoved; // The number of removed pieces
+	uint8_t numberOfAdded; // The number of added pieces
+	uint8_t removed[2][3]; // Color, type and square of each removed piece
+	uint8_t added[2][3]; // Color, type and square of each added piece
+	bool valid; // False if the accumulator before the move is unknown (it has to be refreshed from the board)
+
+	inline void remove(const int color, const int type, const int square) { removed[numberOfRemoved][0] = color, removed[numberOfRemoved][1] = type, removed[numberOfRemoved][2] = square; numberOfRemoved++; }
+	inline void add(const int color, const int type, const int square) { added[numberOfAdded][0] = color, added[numberOfAdded][1] = type, added[numberOfAdded][2] = square; numberOfAdded++; }
+};
+
+// Efficiently updatable neural network (768 -> 2x256 -> 1). The accumulators are updated with the pieces that change on every move,
+// so only the small output layer is computed for each evaluation
+class NNUE
+{
+public:
+	NNUE(); // Network constructor (no network is loaded)
+	~NNUE(); // Network destructor
+
+	bool load(const std::string& path); // Map the network file with the given name, or use the embedded network for NNUE_EMBEDDED_NETWORK (files of another format or size are rejected)
+	void unload(); // Release the loaded network
+	bool isLoaded() const; // True if a network is loaded
+	uint64_t getSignature() const; // Get a hash of the parameters of the loaded network (0 if none is loaded)
+	static bool hasEmbeddedNetwork(); // True if a network was built into the binary
+
+	// Write a network file with the given quantized parameters (as loaded by load)
+	static bool save(const std::string& path, const int16_t* featureWeights, const int16_t* featureBiases, const int16_t* outputWeights, const int32_t outputBias);
+
+	const NNUEKernels& getKernels() const; // Get the kernels the network is computed with
+	void setKernels(const NNUEKernels& kernels); // Compute the network with the given kernels (the fastest ones the CPU supports are used by default)
+
+	// Get the input of the given piece color and type on the given square, seen from the given perspective (each side sees itself as white)
+	static inline int featureIndex(const int perspective, const int color, const int type, const int square)
+	{
+		return perspective == 0 ? color * 384 + type * 64 + square : (color ^ 1) * 384 + type * 64 + (square ^ 56);
+	}
+
+	void refresh(Accumulator& accumulator, const uint64_t pieces[2][6]) const; // Compute the accumulator of the given pieces from scratch
+	void update(const Accumulator& previous, Accumulator& accumulator, const AccumulatorUpdate& update) const; // Compute the accumulator after a move from the accumulator before it
+
+	int evaluate(const Accumulator& accumulator, const int sideToMove) const; // Evaluate the accumulator in centipawns, from the side to move's point of view
+
+private:
+	struct FileHeader
+	{
+		uint64_t magic; // Always NNUE_FILE_MAGIC
+		uint32_t version; // The version of the file format
+		uint32_t inputSize; // The number of inputs
+		uint32_t hiddenSize; // The size of the accumulator of each perspective
+		uint32_t reserved[11]; // Padding that keeps the weights 64 bytes aligned
+	};
+
+	enum class Storage { NONE, MAPPED_FILE, EMBEDDED, COPY };
+
+	Storage storage; // Where the parameters are
+	void* memory; // The file mapping or the copy of the parameters (nullptr for the embedded network, which is never released)
+	size_t memorySize; // The size of the file mapping
+	const int16_t* featureWeights; // Feature transformer weights (indexed [input][hidden])
+	const int16_t* featureBiases; // Feature transformer biases
+	const int16_t* outputWeights; // Output weights (side to move accumulator first)
+	int32_t outputBias; // Output bias (quantized by NNUE_QA * NNUE_QB)
+	uint64_t signature; // Hash of the parameters (tells networks apart, for example for stored search results)
+	const NNUEKernels* kernels; // The kernels the network is computed with
+
+	static size_t getParametersSize(); // The size of the parameters following the file header
+	static const void* getEmbeddedNetwork(size_t& size); // Get the file image built into the binary (nullptr if there is none)
+	bool useImage(const void* image, const size_t size); // Point the parameters into the given file image (false if it is not a valid network)
+};
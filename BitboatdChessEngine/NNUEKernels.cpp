@@ -0,0 +1,254 @@
+#include "NNUEKernels.h"
+#include "NNUE.h"
+#include "SystemHelper.h"
+#include <algorithm>
+#include <immintrin.h>
+
+// MSVC compiles intrinsics of every instruction set anywhere, GCC and Clang have to be told which functions may use them
+#if defined(_MSC_VER)
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#endif
+
+static void accumulateScalar(int16_t* values, const int16_t* biases, const int16_t* const* rows, const int numberOfRows)
+{
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+		values[i] = biases[i];
+
+	for (int j = 0; j < numberOfRows; j++)
+		for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+			values[i] += rows[j][i];
+}
+
+static void updateScalar(const int16_t* before, int16_t* after, const int16_t* const* removedRows, const int numberOfRemoved, const int16_t* const* addedRows, const int numberOfAdded)
+{
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+	{
+		int value = before[i] - removedRows[0][i] + addedRows[0][i];
+		if (numberOfRemoved == 2)
+			value -= removedRows[1][i];
+		if (numberOfAdded == 2)
+			value += addedRows[1][i];
+		after[i] = static_cast<int16_t>(value);
+	}
+}
+
+static int32_t outputScalar(const int16_t* us, const int16_t* them, const int16_t* weights)
+{
+	int32_t sum = 0;
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+	{
+		sum += std::min<int32_t>(std::max<int32_t>(us[i], 0), NNUE_QA) * weights[i];
+		sum += std::min<int32_t>(std::max<int32_t>(them[i], 0), NNUE_QA) * weights[NNUE_HIDDEN_SIZE + i];
+	}
+
+	return sum;
+}
+
+TARGET_SSE41 static void accumulateSse41(int16_t* values, const int16_t* biases, const int16_t* const* rows, const int numberOfRows)
+{
+	// 128 values are kept in 16 registers while all rows are added
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 128)
+	{
+		__m128i sums[16];
+		for (int k = 0; k < 16; k++)
+			sums[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(biases + i) + k);
+
+		for (int j = 0; j < numberOfRows; j++)
+			for (int k = 0; k < 16; k++)
+				sums[k] = _mm_add_epi16(sums[k], _mm_load_si128(reinterpret_cast<const __m128i*>(rows[j] + i) + k));
+
+		for (int k = 0; k < 16; k++)
+			_mm_store_si128(reinterpret_cast<__m128i*>(values + i) + k, sums[k]);
+	}
+}
+
+TARGET_SSE41 static void updateSse41(const int16_t* before, int16_t* after, const int16_t* const* removedRows, const int numberOfRemoved, const int16_t* const* addedRows, const int numberOfAdded)
+{
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 8)
+	{
+		__m128i value = _mm_load_si128(reinterpret_cast<const __m128i*>(before + i));
+		value = _mm_sub_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(removedRows[0] + i)));
+		value = _mm_add_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(addedRows[0] + i)));
+		if (numberOfRemoved == 2)
+			value = _mm_sub_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(removedRows[1] + i)));
+		if (numberOfAdded == 2)
+			value = _mm_add_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(addedRows[1] + i)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(after + i), value);
+	}
+}
+
+TARGET_SSE41 static int32_t outputSse41(const int16_t* us, const int16_t* them, const int16_t* weights)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i maximum = _mm_set1_epi16(NNUE_QA);
+	__m128i sum = _mm_setzero_si128();
+
+	// The clipped values and the weights both fit 16 bits, their products are summed in pairs into 32 bits
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 8)
+	{
+		const __m128i usValues = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(us + i)), zero), maximum);
+		const __m128i themValues = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(them + i)), zero), maximum);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(usValues, _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i))));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(themValues, _mm_load_si128(reinterpret_cast<const __m128i*>(weights + NNUE_HIDDEN_SIZE + i))));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+
+TARGET_AVX2 static void accumulateAvx2(int16_t* values, const int16_t* biases, const int16_t* const* rows, const int numberOfRows)
+{
+	// 256 values are kept in 16 registers while all rows are added
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 256)
+	{
+		__m256i sums[16];
+		for (int k = 0; k < 16; k++)
+			sums[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(biases + i) + k);
+
+		for (int j = 0; j < numberOfRows; j++)
+			for (int k = 0; k < 16; k++)
+				sums[k] = _mm256_add_epi16(sums[k], _mm256_load_si256(reinterpret_cast<const __m256i*>(rows[j] + i) + k));
+
+		for (int k = 0; k < 16; k++)
+			_mm256_store_si256(reinterpret_cast<__m256i*>(values + i) + k, sums[k]);
+	}
+}
+
+TARGET_AVX2 static void updateAvx2(const int16_t* before, int16_t* after, const int16_t* const* removedRows, const int numberOfRemoved, const int16_t* const* addedRows, const int numberOfAdded)
+{
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 16)
+	{
+		__m256i value = _mm256_load_si256(reinterpret_cast<const __m256i*>(before + i));
+		value = _mm256_sub_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(removedRows[0] + i)));
+		value = _mm256_add_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(addedRows[0] + i)));
+		if (numberOfRemoved == 2)
+			value = _mm256_sub_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(removedRows[1] + i)));
+		if (numberOfAdded == 2)
+			value = _mm256_add_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(addedRows[1] + i)));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(after + i), value);
+	}
+}
+
+TARGET_AVX2 static int32_t outputAvx2(const int16_t* us, const int16_t* them, const int16_t* weights)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i maximum = _mm256_set1_epi16(NNUE_QA);
+	__m256i sum = _mm256_setzero_si256();
+
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 16)
+	{
+		const __m256i usValues = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(us + i)), zero), maximum);
+		const __m256i themValues = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(them + i)), zero), maximum);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(usValues, _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i))));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(themValues, _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + NNUE_HIDDEN_SIZE + i))));
+	}
+
+	// Fold the two 128 bit lanes, then the 32 bit sums
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(half);
+}
+
+TARGET_AVX512 static void accumulateAvx512(int16_t* values, const int16_t* biases, const int16_t* const* rows, const int numberOfRows)
+{
+	// The whole accumulator fits in 8 registers
+	__m512i sums[NNUE_HIDDEN_SIZE / 32];
+	for (int k = 0; k < NNUE_HIDDEN_SIZE / 32; k++)
+		sums[k] = _mm512_load_si512(reinterpret_cast<const __m512i*>(biases) + k);
+
+	for (int j = 0; j < numberOfRows; j++)
+		for (int k = 0; k < NNUE_HIDDEN_SIZE / 32; k++)
+			sums[k] = _mm512_add_epi16(sums[k], _mm512_load_si512(reinterpret_cast<const __m512i*>(rows[j]) + k));
+
+	for (int k = 0; k < NNUE_HIDDEN_SIZE / 32; k++)
+		_mm512_store_si512(reinterpret_cast<__m512i*>(values) + k, sums[k]);
+}
+
+TARGET_AVX512 static void updateAvx512(const int16_t* before, int16_t* after, const int16_t* const* removedRows, const int numberOfRemoved, const int16_t* const* addedRows, const int numberOfAdded)
+{
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 32)
+	{
+		__m512i value = _mm512_load_si512(before + i);
+		value = _mm512_sub_epi16(value, _mm512_load_si512(removedRows[0] + i));
+		value = _mm512_add_epi16(value, _mm512_load_si512(addedRows[0] + i));
+		if (numberOfRemoved == 2)
+			value = _mm512_sub_epi16(value, _mm512_load_si512(removedRows[1] + i));
+		if (numberOfAdded == 2)
+			value = _mm512_add_epi16(value, _mm512_load_si512(addedRows[1] + i));
+		_mm512_store_si512(after + i, value);
+	}
+}
+
+TARGET_AVX512 static int32_t outputAvx512(const int16_t* us, const int16_t* them, const int16_t* weights)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i maximum = _mm512_set1_epi16(NNUE_QA);
+	__m512i sum = _mm512_setzero_si512();
+
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i += 32)
+	{
+		const __m512i usValues = _mm512_min_epi16(_mm512_max_epi16(_mm512_load_si512(us + i), zero), maximum);
+		const __m512i themValues = _mm512_min_epi16(_mm512_max_epi16(_mm512_load_si512(them + i), zero), maximum);
+		sum = _mm512_add_epi32(sum, _mm512_madd_epi16(usValues, _mm512_load_si512(weights + i)));
+		sum = _mm512_add_epi32(sum, _mm512_madd_epi16(themValues, _mm512_load_si512(weights + NNUE_HIDDEN_SIZE + i)));
+	}
+
+	// Sum the 32 bit lanes (once per evaluation, so a store is as fast as shuffling)
+	alignas(64) int32_t lanes[16];
+	_mm512_store_si512(lanes, sum);
+	int32_t total = 0;
+	for (int k = 0; k < 16; k++)
+		total += lanes[k];
+	return total;
+}
+
+static const NNUEKernels kernels[] =
+{
+	{ NNUEKernels::Level::SCALAR, "scalar", accumulateScalar, updateScalar, outputScalar },
+	{ NNUEKernels::Level::SSE41, "SSE4.1", accumulateSse41, updateSse41, outputSse41 },
+	{ NNUEKernels::Level::AVX2, "AVX2", accumulateAvx2, updateAvx2, outputAvx2 },
+	{ NNUEKernels::Level::AVX512, "AVX-512", accumulateAvx512, updateAvx512, outputAvx512 },
+};
+
+bool NNUEKernels::isSupported(const Level level)
+{
+	static const SystemHelper::CpuFeatures features = SystemHelper::getCpuFeatures();
+
+	switch (level)
+	{
+	case Level::SSE41:
+		return features.sse41;
+	case Level::AVX2:
+		return features.avx2;
+	case Level::AVX512:
+		return features.avx512;
+	default:
+		return true;
+	}
+}
+
+const NNUEKernels& NNUEKernels::get(const Level level)
+{
+	return kernels[static_cast<int>(level)];
+}
+
+const NNUEKernels& NNUEKernels::getBest()
+{
+	static const NNUEKernels& best = []() -> const NNUEKernels&
+	{
+		for (int level = static_cast<int>(Level::AVX512); level > static_cast<int>(Level::SCALAR); level--)
+			if (isSupported(static_cast<Level>(level)))
+				return kernels[level];
+		return kernels[0];
+	}();
+
+	return best;
+}
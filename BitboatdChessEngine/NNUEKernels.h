@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// The loops of the network inference, built for several instruction sets. One binary runs on every host and uses the fastest set the CPU supports
+struct NNUEKernels
+{
+	enum class Level { SCALAR, SSE41, AVX2, AVX512 };
+
+	Level level; // The instruction set the kernels are built for
+	const char* name; // The name of the instruction set
+
+	// Set the accumulator values to the biases plus the given weight rows
+	void (*accumulate)(int16_t* values, const int16_t* biases, const int16_t* const* rows, const int numberOfRows);
+	// Set the accumulator values after a move to the values before it minus the removed rows plus the added rows (one or two of each)
+	void (*update)(const int16_t* before, int16_t* after, const int16_t* const* removedRows, const int numberOfRemoved, const int16_t* const* addedRows, const int numberOfAdded);
+	// Get the affine output of the clipped ReLU of both accumulators (side to move first), without the bias
+	int32_t (*output)(const int16_t* us, const int16_t* them, const int16_t* weights);
+
+	static bool isSupported(const Level level); // True if the host CPU can run the kernels of the given instruction set
+	static const NNUEKernels& get(const Level level); // Get the kernels of the given instruction set
+	static const NNUEKernels& getBest(); // Get the fastest kernels the host CPU supports (chosen once at startup)
+};
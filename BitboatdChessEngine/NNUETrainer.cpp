@@ -0,0 +1,447 @@
+#include "NNUETrainer.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+// The largest weight that still fits the quantized format: output weights times NNUE_QB stay within 8 bits, so the sums of the output layer can not
+// overflow 32 bits, and 32 feature weights times NNUE_QA can not overflow the 16 bit accumulators
+constexpr float WEIGHT_LIMIT = 127.0f / NNUE_QB;
+
+constexpr float SIGMOID_SCALE = 400.0f; // Centipawns of a score that maps to a win probability of 1 / (1 + e^-1)
+
+constexpr float ADAM_BETA1 = 0.9f;
+constexpr float ADAM_BETA2 = 0.999f;
+constexpr float ADAM_EPSILON = 1e-8f;
+
+static inline float sigmoid(const float x)
+{
+	return 1.0f / (1.0f + std::exp(-x));
+}
+
+NNUETrainer::Settings::Settings()
+{
+	this->epochs = 10;
+	this->batchSize = 16384;
+	this->threads = std::max(1u, std::thread::hardware_concurrency());
+	this->learningRate = 0.001f;
+	this->lambda = 0.75f;
+}
+
+NNUETrainer::NNUETrainer()
+{
+	this->parameters.assign(parametersSize, 0.0f);
+	this->firstMoments.assign(parametersSize, 0.0f);
+	this->secondMoments.assign(parametersSize, 0.0f);
+	this->step = 0;
+
+	// Uniform weights scaled by the number of inputs of each layer (about 32 pieces for the feature transformer), biases start at 0
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> featureDistribution(-1.0f / std::sqrt(32.0f), 1.0f / std::sqrt(32.0f));
+	std::uniform_real_distribution<float> outputDistribution(-1.0f / std::sqrt(2.0f * NNUE_HIDDEN_SIZE), 1.0f / std::sqrt(2.0f * NNUE_HIDDEN_SIZE));
+
+	for (int i = 0; i < featureBiasesOffset; i++)
+		this->parameters[i] = featureDistribution(generator);
+	for (int i = outputWeightsOffset; i < outputBiasOffset; i++)
+		this->parameters[i] = outputDistribution(generator);
+
+	this->quantizedParameters.resize(parametersSize);
+	for (int i = 0; i < parametersSize; i++)
+		this->quantizedParameters[i] = quantize(i, this->parameters[i]);
+}
+
+float NNUETrainer::quantize(const int index, const float value)
+{
+	const float scale = index < outputWeightsOffset ? NNUE_QA : index < outputBiasOffset ? NNUE_QB : NNUE_QA * NNUE_QB;
+	return std::round(value * scale) / scale;
+}
+
+bool NNUETrainer::parsePosition(const std::string& line, PackedPosition& position)
+{
+	const size_t scoreStart = line.find('|');
+	const size_t resultStart = scoreStart == std::string::npos ? std::string::npos : line.find('|', scoreStart + 1);
+	if (resultStart == std::string::npos)
+		return false;
+
+	memset(&position, 0, sizeof(position));
+
+	// Board and side to move of the FEN (the other fields do not change the network inputs)
+	int board[64];
+	std::fill(board, board + 64, -1);
+	int square = 56;
+	size_t i = 0;
+	while (i < scoreStart && line[i] == ' ')
+		i++;
+
+	for (; i < scoreStart && line[i] != ' '; i++)
+	{
+		const char character = line[i];
+		if (character == '/')
+		{
+			square -= 16;
+		}
+		else if ('1' <= character && character <= '8')
+		{
+			square += character - '0';
+		}
+		else
+		{
+			static const std::string pieceCharacters = "pnbrqk";
+			const size_t type = pieceCharacters.find(static_cast<char>(tolower(character)));
+			if (type == std::string::npos || square < 0 || square > 63)
+				return false;
+
+			board[square] = (isupper(character) ? 0 : 1) << 3 | static_cast<int>(type);
+			square++;
+		}
+	}
+
+	while (i < scoreStart && line[i] == ' ')
+		i++;
+	position.activePlayer = i < scoreStart && line[i] == 'b' ? 1 : 0;
+
+	int numberOfPieces = 0;
+	for (square = 0; square < 64; square++)
+	{
+		if (board[square] < 0)
+			continue;
+		if (numberOfPieces == 32)
+			return false;
+
+		position.occupancy |= 1ULL << square;
+		position.pieces[numberOfPieces / 2] |= static_cast<uint8_t>(board[square] << (4 * (numberOfPieces % 2)));
+		numberOfPieces++;
+	}
+
+	// Score and result
+	std::istringstream scoreStream(line.substr(scoreStart + 1, resultStart - scoreStart - 1));
+	int score = 0;
+	if (!(scoreStream >> score))
+		return false;
+	position.score = static_cast<int16_t>(std::min(std::max(score, -32000), 32000));
+
+	std::istringstream resultStream(line.substr(resultStart + 1));
+	float result = 0.0f;
+	if (!(resultStream >> result))
+		return false;
+	position.result = static_cast<uint8_t>(std::lround(std::min(std::max(result, 0.0f), 1.0f) * 2.0f));
+
+	return true;
+}
+
+long long NNUETrainer::packPositions(const std::string& textPath, const std::string& packedPath)
+{
+	std::ifstream input(textPath);
+	std::ofstream output(packedPath, std::ios::binary);
+	if (!input || !output)
+		return -1;
+
+	long long numberOfPositions = 0;
+	std::string line;
+	while (std::getline(input, line))
+	{
+		PackedPosition position;
+		if (!parsePosition(line, position))
+			continue;
+
+		output.write(reinterpret_cast<const char*>(&position), sizeof(position));
+		numberOfPositions++;
+	}
+
+	return output ? numberOfPositions : -1;
+}
+
+bool NNUETrainer::loadPositions(const std::string& packedPath)
+{
+	std::ifstream file(packedPath, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+
+	const std::streamoff size = file.tellg();
+	if (size % sizeof(PackedPosition) != 0)
+		return false;
+
+	this->positions.resize(static_cast<size_t>(size / sizeof(PackedPosition)));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(this->positions.data()), size);
+
+	return static_cast<bool>(file);
+}
+
+size_t NNUETrainer::getNumberOfPositions() const
+{
+	return this->positions.size();
+}
+
+int NNUETrainer::getFeatures(const PackedPosition& position, int features[2][32])
+{
+	uint64_t occupancy = position.occupancy;
+	int numberOfPieces = 0;
+
+	while (occupancy)
+	{
+		const int square = static_cast<int>(_tzcnt_u64(occupancy));
+		const int piece = (position.pieces[numberOfPieces / 2] >> (4 * (numberOfPieces % 2))) & 0xF;
+
+		features[0][numberOfPieces] = NNUE::featureIndex(0, piece >> 3, piece & 7, square);
+		features[1][numberOfPieces] = NNUE::featureIndex(1, piece >> 3, piece & 7, square);
+		numberOfPieces++;
+		occupancy &= occupancy - 1;
+	}
+
+	return numberOfPieces;
+}
+
+float NNUETrainer::forward(const int features[2][32], const int numberOfPieces, const int activePlayer, float accumulators[2][NNUE_HIDDEN_SIZE]) const
+{
+	const float* featureWeights = this->quantizedParameters.data();
+	const float* featureBiases = featureWeights + featureBiasesOffset;
+	const float* outputWeights = featureWeights + outputWeightsOffset;
+
+	// Only the rows of the pieces on the board are added (the inputs are sparse), the loops over the accumulator vectorize
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		float* accumulator = accumulators[perspective];
+		memcpy(accumulator, featureBiases, sizeof(float) * NNUE_HIDDEN_SIZE);
+
+		for (int j = 0; j < numberOfPieces; j++)
+		{
+			const float* row = featureWeights + static_cast<size_t>(features[perspective][j]) * NNUE_HIDDEN_SIZE;
+			for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+				accumulator[i] += row[i];
+		}
+	}
+
+	// Clipped ReLU (1.0 is NNUE_QA once quantized) and the output layer, side to move first
+	const float* us = accumulators[activePlayer];
+	const float* them = accumulators[activePlayer ^ 1];
+	float output = this->quantizedParameters[outputBiasOffset];
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+		output += std::min(std::max(us[i], 0.0f), 1.0f) * outputWeights[i] + std::min(std::max(them[i], 0.0f), 1.0f) * outputWeights[NNUE_HIDDEN_SIZE + i];
+
+	return output;
+}
+
+float NNUETrainer::computeGradient(const PackedPosition& position, const float lambda, float* gradient) const
+{
+	int features[2][32];
+	const int numberOfPieces = getFeatures(position, features);
+	const int activePlayer = position.activePlayer;
+
+	alignas(64) float accumulators[2][NNUE_HIDDEN_SIZE];
+	const float output = forward(features, numberOfPieces, activePlayer, accumulators);
+
+	// The target mixes the win probability of the search score with the game result, both for the side to move
+	const float score = activePlayer == 0 ? position.score : -position.score;
+	const float result = activePlayer == 0 ? position.result * 0.5f : 1.0f - position.result * 0.5f;
+	const float target = lambda * sigmoid(score / SIGMOID_SCALE) + (1.0f - lambda) * result;
+
+	const float prediction = sigmoid(output * NNUE_SCALE / SIGMOID_SCALE);
+	const float error = prediction - target;
+
+	// Mean squared error of the win probabilities, back through the sigmoid
+	const float outputGradient = 2.0f * error * prediction * (1.0f - prediction) * NNUE_SCALE / SIGMOID_SCALE;
+
+	// The gradient of the rounded parameters is applied to the exact ones
+	const float* outputWeights = this->quantizedParameters.data() + outputWeightsOffset;
+	float* featureWeightsGradient = gradient;
+	float* featureBiasesGradient = gradient + featureBiasesOffset;
+	float* outputWeightsGradient = gradient + outputWeightsOffset;
+
+	gradient[outputBiasOffset] += outputGradient;
+
+	for (int side = 0; side < 2; side++)
+	{
+		// The side to move uses the first half of the output weights
+		const int perspective = side == 0 ? activePlayer : activePlayer ^ 1;
+		const float* accumulator = accumulators[perspective];
+		const float* weights = outputWeights + side * NNUE_HIDDEN_SIZE;
+		float* weightsGradient = outputWeightsGradient + side * NNUE_HIDDEN_SIZE;
+
+		alignas(64) float accumulatorGradient[NNUE_HIDDEN_SIZE];
+		for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+		{
+			const float value = accumulator[i];
+			weightsGradient[i] += outputGradient * std::min(std::max(value, 0.0f), 1.0f);
+			accumulatorGradient[i] = value > 0.0f && value < 1.0f ? outputGradient * weights[i] : 0.0f;
+			featureBiasesGradient[i] += accumulatorGradient[i];
+		}
+
+		for (int j = 0; j < numberOfPieces; j++)
+		{
+			float* rowGradient = featureWeightsGradient + static_cast<size_t>(features[perspective][j]) * NNUE_HIDDEN_SIZE;
+			for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+				rowGradient[i] += accumulatorGradient[i];
+		}
+	}
+
+	return error * error;
+}
+
+void NNUETrainer::computeBatch(const int* batch, const int batchSize, const Settings& settings, std::vector<std::vector<float>>& gradients, double& loss)
+{
+	const int numberOfThreads = static_cast<int>(gradients.size());
+	std::vector<double> threadLosses(numberOfThreads, 0.0);
+	std::vector<std::thread> threads;
+
+	// Every thread sums the gradients of its share of the batch into its own buffer
+	for (int t = 0; t < numberOfThreads; t++)
+		threads.emplace_back([&, t]()
+		{
+			std::vector<float>& gradient = gradients[t];
+			std::fill(gradient.begin(), gradient.end(), 0.0f);
+
+			for (int i = t; i < batchSize; i += numberOfThreads)
+				threadLosses[t] += computeGradient(this->positions[batch[i]], settings.lambda, gradient.data());
+		});
+
+	for (std::thread& thread : threads)
+		thread.join();
+	threads.clear();
+
+	for (int t = 0; t < numberOfThreads; t++)
+		loss += threadLosses[t];
+
+	// Then every thread reduces a slice of the buffers and makes the Adam step for it
+	this->step++;
+	const float firstCorrection = 1.0f / (1.0f - static_cast<float>(std::pow(ADAM_BETA1, this->step)));
+	const float secondCorrection = 1.0f / (1.0f - static_cast<float>(std::pow(ADAM_BETA2, this->step)));
+	const int sliceSize = (parametersSize + numberOfThreads - 1) / numberOfThreads;
+
+	for (int t = 0; t < numberOfThreads; t++)
+		threads.emplace_back([&, t]()
+		{
+			const int start = t * sliceSize;
+			const int end = std::min(start + sliceSize, parametersSize);
+
+			for (int i = start; i < end; i++)
+			{
+				float gradient = 0.0f;
+				for (int k = 0; k < numberOfThreads; k++)
+					gradient += gradients[k][i];
+				gradient /= batchSize;
+
+				this->firstMoments[i] = ADAM_BETA1 * this->firstMoments[i] + (1.0f - ADAM_BETA1) * gradient;
+				this->secondMoments[i] = ADAM_BETA2 * this->secondMoments[i] + (1.0f - ADAM_BETA2) * gradient * gradient;
+
+				float parameter = this->parameters[i] - settings.learningRate * (this->firstMoments[i] * firstCorrection) /
+					(std::sqrt(this->secondMoments[i] * secondCorrection) + ADAM_EPSILON);
+
+				// Keep the weights in the range the quantized network can hold (the output bias is 32 bits)
+				if (i != outputBiasOffset)
+					parameter = std::min(std::max(parameter, -WEIGHT_LIMIT), WEIGHT_LIMIT);
+				this->parameters[i] = parameter;
+				this->quantizedParameters[i] = quantize(i, parameter);
+			}
+		});
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+void NNUETrainer::train(const Settings& settings, const std::string& networkPath)
+{
+	if (this->positions.empty())
+		return;
+
+	const int numberOfThreads = std::max(1, settings.threads);
+	const int batchSize = static_cast<int>(std::min<size_t>(std::max(1, settings.batchSize), this->positions.size()));
+	std::vector<std::vector<float>> gradients(numberOfThreads, std::vector<float>(parametersSize));
+
+	std::vector<int> order(this->positions.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = static_cast<int>(i);
+	std::mt19937 generator(1);
+
+	for (int epoch = 1; epoch <= settings.epochs; epoch++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		std::shuffle(order.begin(), order.end(), generator);
+
+		// The positions left over after the last full batch are used in the next epoch's order
+		double loss = 0.0;
+		const size_t numberOfBatches = order.size() / batchSize;
+		for (size_t batch = 0; batch < numberOfBatches; batch++)
+			computeBatch(order.data() + batch * batchSize, batchSize, settings, gradients, loss);
+
+		auto stop = std::chrono::steady_clock::now();
+		const long long time = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+		const unsigned long long positionsTrained = static_cast<unsigned long long>(numberOfBatches) * batchSize;
+
+		std::cout << "info string epoch " << epoch << "/" << settings.epochs << " loss " << loss / std::max(1ULL, positionsTrained)
+			<< " time " << time << " positions/s " << positionsTrained * 1000 / std::max(1LL, time) << "\n";
+
+		if (!exportNetwork(networkPath))
+		{
+			std::cout << "info string Could not write the network " << networkPath << "\n";
+			return;
+		}
+	}
+
+	checkQuantization(networkPath);
+}
+
+bool NNUETrainer::exportNetwork(const std::string& networkPath) const
+{
+	std::vector<int16_t> featureWeights(NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE);
+	std::vector<int16_t> featureBiases(NNUE_HIDDEN_SIZE);
+	std::vector<int16_t> outputWeights(2 * NNUE_HIDDEN_SIZE);
+
+	auto toInteger = [](const float value, const float scale) { return static_cast<int16_t>(std::min<int>(std::max<int>(static_cast<int>(std::lround(value * scale)), INT16_MIN), INT16_MAX)); };
+
+	for (size_t i = 0; i < featureWeights.size(); i++)
+		featureWeights[i] = toInteger(this->parameters[i], NNUE_QA);
+	for (int i = 0; i < NNUE_HIDDEN_SIZE; i++)
+		featureBiases[i] = toInteger(this->parameters[featureBiasesOffset + i], NNUE_QA);
+	for (int i = 0; i < 2 * NNUE_HIDDEN_SIZE; i++)
+		outputWeights[i] = toInteger(this->parameters[outputWeightsOffset + i], NNUE_QB);
+	const int32_t outputBias = static_cast<int32_t>(std::lround(this->parameters[outputBiasOffset] * NNUE_QA * NNUE_QB));
+
+	return NNUE::save(networkPath, featureWeights.data(), featureBiases.data(), outputWeights.data(), outputBias);
+}
+
+void NNUETrainer::checkQuantization(const std::string& networkPath) const
+{
+	NNUE network;
+	if (!network.load(networkPath))
+		return;
+
+	// Compare the integer evaluations of the engine with the ones the network was trained with on a sample of the positions
+	const size_t sampleSize = std::min<size_t>(this->positions.size(), 10000);
+	double totalDifference = 0.0;
+	int maximumDifference = 0;
+
+	for (size_t i = 0; i < sampleSize; i++)
+	{
+		const PackedPosition& position = this->positions[i * this->positions.size() / sampleSize];
+
+		uint64_t pieces[2][6] = {};
+		uint64_t occupancy = position.occupancy;
+		for (int j = 0; occupancy; j++, occupancy &= occupancy - 1)
+		{
+			const int piece = (position.pieces[j / 2] >> (4 * (j % 2))) & 0xF;
+			pieces[piece >> 3][piece & 7] |= 1ULL << _tzcnt_u64(occupancy);
+		}
+
+		Accumulator accumulator;
+		network.refresh(accumulator, pieces);
+		const int quantizedScore = network.evaluate(accumulator, position.activePlayer);
+
+		int features[2][32];
+		alignas(64) float accumulators[2][NNUE_HIDDEN_SIZE];
+		const int numberOfPieces = getFeatures(position, features);
+		const int floatScore = static_cast<int>(forward(features, numberOfPieces, position.activePlayer, accumulators) * NNUE_SCALE);
+
+		totalDifference += std::abs(quantizedScore - floatScore);
+		maximumDifference = std::max(maximumDifference, std::abs(quantizedScore - floatScore));
+	}
+
+	std::cout << "info string quantization error (centipawns) average " << totalDifference / std::max<size_t>(1, sampleSize)
+		<< " maximum " << maximumDifference << "\n";
+}
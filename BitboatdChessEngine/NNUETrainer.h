@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "NNUE.h"
+
+// A training position packed into 32 bytes
+struct PackedPosition
+{
+	uint64_t occupancy; // The occupied squares
+	uint8_t pieces[16]; // Color (high bit) and type of each piece in square order, two pieces per byte (low half first)
+	int16_t score; // The search score from white's point of view (centipawns)
+	uint8_t result; // The game result from white's point of view (0 loss, 1 draw, 2 win)
+	uint8_t activePlayer; // The side to move
+	uint8_t reserved[4]; // Padding up to 32 bytes
+};
+
+static_assert(sizeof(PackedPosition) == 32, "Packed positions have to stay 32 bytes");
+
+// Trains the engine's network on the CPU (mini-batch Adam on all cores) and exports it quantized to the format NNUE loads
+class NNUETrainer
+{
+public:
+	struct Settings
+	{
+		int epochs; // The number of passes over the positions
+		int batchSize; // The number of positions per gradient step
+		int threads; // The number of threads computing the gradients
+		float learningRate; // The Adam step size
+		float lambda; // The weight of the search score in the target (the game result gets the rest)
+
+		Settings();
+	};
+
+	// Convert a text file of "<fen> | <score> | <result>" lines (score from white's point of view, result 1.0, 0.5 or 0.0 for white) to packed positions.
+	// Returns the number of positions written, or -1 if a file can not be opened
+	static long long packPositions(const std::string& textPath, const std::string& packedPath);
+
+	NNUETrainer(); // Trainer constructor (the network starts with small random weights)
+
+	bool loadPositions(const std::string& packedPath); // Load the packed training positions of the given file
+	size_t getNumberOfPositions() const; // The number of loaded positions
+
+	void train(const Settings& settings, const std::string& networkPath); // Train on the loaded positions, exporting the network to the given file after every epoch
+	bool exportNetwork(const std::string& networkPath) const; // Quantize the network and write it to the given file
+
+private:
+	static const int parametersSize = NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE + NNUE_HIDDEN_SIZE + 2 * NNUE_HIDDEN_SIZE + 1; // The number of network parameters
+	static const int featureBiasesOffset = NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE; // The offset of the feature biases in the parameters
+	static const int outputWeightsOffset = featureBiasesOffset + NNUE_HIDDEN_SIZE; // The offset of the output weights in the parameters
+	static const int outputBiasOffset = outputWeightsOffset + 2 * NNUE_HIDDEN_SIZE; // The offset of the output bias in the parameters
+
+	std::vector<PackedPosition> positions; // The training positions
+	std::vector<float> parameters; // The network parameters (feature weights, feature biases, output weights, output bias)
+	std::vector<float> quantizedParameters; // The parameters rounded as they are exported (the network is trained through them, so rounding does not cost accuracy)
+	std::vector<float> firstMoments; // Adam moving average of the gradients
+	std::vector<float> secondMoments; // Adam moving average of the squared gradients
+	long long step; // The number of Adam steps made
+
+	static float quantize(const int index, const float value); // Round the parameter of the given index to the precision it is exported with
+	static bool parsePosition(const std::string& line, PackedPosition& position); // Parse a "<fen> | <score> | <result>" line
+	static int getFeatures(const PackedPosition& position, int features[2][32]); // Get the active inputs of both perspectives (returns the number of pieces)
+
+	float forward(const int features[2][32], const int numberOfPieces, const int activePlayer, float accumulators[2][NNUE_HIDDEN_SIZE]) const; // Compute the network output (1.0 is NNUE_SCALE centipawns)
+	float computeGradient(const PackedPosition& position, const float lambda, float* gradient) const; // Add the loss gradient of the position to the given buffer (returns the loss)
+	void computeBatch(const int* batch, const int batchSize, const Settings& settings, std::vector<std::vector<float>>& gradients, double& loss); // Compute the gradient of a batch on all threads and step the parameters
+	void checkQuantization(const std::string& networkPath) const; // Report how far the evaluations of the exported network are from the trained one
+};
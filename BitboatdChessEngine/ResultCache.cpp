@@ -0,0 +1,162 @@
+#include "ResultCache.h"
+#include "SystemHelper.h"
+#include <cstring>
+#include <algorithm>
+
+ResultCache::ResultCache()
+{
+	this->mapping = nullptr;
+	this->header = nullptr;
+	this->entries = nullptr;
+}
+
+ResultCache::~ResultCache()
+{
+	close();
+}
+
+size_t ResultCache::getFileSize()
+{
+	return sizeof(FileHeader) + static_cast<size_t>(numberOfEntries) * sizeof(Entry);
+}
+
+bool ResultCache::open(const std::string& path, const uint64_t zobristSignature)
+{
+	close();
+
+	void* fileMapping = SystemHelper::mapPersistentFile(path, getFileSize());
+	if (fileMapping == nullptr)
+		return false;
+
+	this->mapping = fileMapping;
+	this->header = static_cast<FileHeader*>(fileMapping);
+	this->entries = reinterpret_cast<Entry*>(static_cast<char*>(fileMapping) + sizeof(FileHeader));
+	this->statistics = Statistics();
+
+	// A new file is all zeros, and results stored with other zobrist hashes would be found under the wrong positions, so both start empty
+	if (this->header->magic != RESULT_CACHE_FILE_MAGIC || this->header->version != RESULT_CACHE_FILE_VERSION ||
+		this->header->entrySize != sizeof(Entry) || this->header->numberOfEntries != numberOfEntries ||
+		this->header->zobristSignature != zobristSignature)
+	{
+		memset(fileMapping, 0, getFileSize());
+		this->header->magic = RESULT_CACHE_FILE_MAGIC;
+		this->header->version = RESULT_CACHE_FILE_VERSION;
+		this->header->entrySize = sizeof(Entry);
+		this->header->numberOfEntries = numberOfEntries;
+		this->header->zobristSignature = zobristSignature;
+	}
+
+	return true;
+}
+
+void ResultCache::close()
+{
+	if (this->mapping == nullptr)
+		return;
+
+	SystemHelper::unmapFile(this->mapping, getFileSize());
+	this->mapping = nullptr;
+	this->header = nullptr;
+	this->entries = nullptr;
+}
+
+bool ResultCache::isOpen() const
+{
+	return this->mapping != nullptr;
+}
+
+ResultCache::Entry* ResultCache::findEntry(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature) const
+{
+	Entry* bucket = this->entries + (zobristHash & (numberOfEntries - 1) & ~(bucketSize - 1));
+
+	// The side to move and the castling rights are part of the zobrist hash, they are checked again to rule out collisions between them
+	for (int i = 0; i < bucketSize; i++)
+		if (bucket[i].lastUsed != 0 && bucket[i].zobristHash == zobristHash && bucket[i].activePlayer == activePlayer && bucket[i].castlingRights == castlingRights &&
+			bucket[i].evaluationSignature == evaluationSignature)
+			return &bucket[i];
+
+	return nullptr;
+}
+
+bool ResultCache::probe(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature, const int minimumDepth, Result& result)
+{
+	if (!isOpen())
+		return false;
+
+	Entry* entry = findEntry(zobristHash, activePlayer, castlingRights, evaluationSignature);
+	if (entry == nullptr || entry->depth < minimumDepth)
+	{
+		this->statistics.misses++;
+		return false;
+	}
+
+	entry->lastUsed = ++this->header->clock;
+
+	result.depth = entry->depth;
+	result.score = entry->score;
+	result.principalVariation = MoveList();
+	for (int i = 0; i < entry->principalVariationLength; i++)
+		result.principalVariation.add(Move(entry->principalVariation[i]));
+
+	return true;
+}
+
+void ResultCache::countHit()
+{
+	this->statistics.hits++;
+}
+
+void ResultCache::invalidate(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature)
+{
+	if (!isOpen())
+		return;
+
+	// An entry that was never used is empty, so the next result of the position can take its place even if it is shallower
+	Entry* entry = findEntry(zobristHash, activePlayer, castlingRights, evaluationSignature);
+	if (entry != nullptr)
+		entry->lastUsed = 0;
+
+	this->statistics.misses++;
+}
+
+void ResultCache::store(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature, const Result& result)
+{
+	if (!isOpen() || result.principalVariation.numberOfMoves == 0)
+		return;
+
+	Entry* entry = findEntry(zobristHash, activePlayer, castlingRights, evaluationSignature);
+	if (entry != nullptr && entry->depth > result.depth)
+	{
+		// Keep the deeper result, but count the access so it is not evicted
+		entry->lastUsed = ++this->header->clock;
+		return;
+	}
+
+	// Replace the least recently used entry of the bucket (empty entries have never been used)
+	if (entry == nullptr)
+	{
+		Entry* bucket = this->entries + (zobristHash & (numberOfEntries - 1) & ~(bucketSize - 1));
+		entry = &bucket[0];
+		for (int i = 1; i < bucketSize; i++)
+			if (bucket[i].lastUsed < entry->lastUsed)
+				entry = &bucket[i];
+	}
+
+	entry->zobristHash = zobristHash;
+	entry->lastUsed = ++this->header->clock;
+	entry->score = result.score;
+	entry->activePlayer = static_cast<uint8_t>(activePlayer);
+	entry->castlingRights = castlingRights;
+	entry->evaluationSignature = evaluationSignature;
+	entry->depth = static_cast<uint8_t>(result.depth);
+	entry->principalVariationLength = static_cast<uint8_t>(std::min<int>(result.principalVariation.numberOfMoves, MAX_PRINCIPAL_VARIATION_LENGTH));
+	for (int i = 0; i < entry->principalVariationLength; i++)
+		entry->principalVariation[i] = result.principalVariation.moves[i].raw();
+
+	this->statistics.stores++;
+}
+
+ResultCache::Statistics ResultCache::getStatistics() const
+{
+	return this->statistics;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Move.h"
+
+constexpr int MAX_PRINCIPAL_VARIATION_LENGTH = 16; // The number of principal variation moves kept for a cached result
+
+constexpr uint64_t RESULT_CACHE_FILE_MAGIC = 0x0031484341435254ULL; // "TRCACH1" marks a result cache file
+constexpr uint32_t RESULT_CACHE_FILE_VERSION = 2; // Version of the result cache file format
+
+// Memory mapped file of finished search results, so positions asked for again (even by another run of the engine) are answered without searching
+class ResultCache
+{
+public:
+	struct Result
+	{
+		int depth; // The depth the position was searched to
+		int score; // The score of the position
+		MoveList principalVariation; // The principal variation (the first move is the best move)
+
+		Result() : depth(0), score(0) {}
+	};
+
+	struct Statistics
+	{
+		unsigned long long hits; // Probes that found a result searched deep enough that the caller used
+		unsigned long long misses; // Probes that found no result, one searched too shallow, or one the caller dropped
+		unsigned long long stores; // Results stored
+
+		Statistics() : hits(0), misses(0), stores(0) {}
+	};
+
+	ResultCache(); // Result cache constructor (the cache is closed until a file is opened)
+	~ResultCache(); // Result cache destructor
+
+	bool open(const std::string& path, const uint64_t zobristSignature); // Map the given cache file, creating it if needed (a file made with other zobrist hashes is cleared)
+	void close(); // Unmap the cache file
+	bool isOpen() const; // True if a cache file is mapped
+
+	// Get the result of the given position searched with the given evaluation to at least the given depth. The caller checks the result
+	// and then counts it with countHit, or drops it with invalidate
+	bool probe(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature, const int minimumDepth, Result& result);
+	void countHit(); // Count a probed result the caller used
+	void invalidate(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature); // Drop the stored result of the given position (counted as a miss)
+	void store(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature, const Result& result); // Store the result of the given position (a deeper result already stored is kept)
+
+	Statistics getStatistics() const; // Get the hit and miss counters since the cache was opened
+
+private:
+	static const int numberOfEntries = 1 << 16; // The number of entries in the file (4 MB)
+	static const int bucketSize = 4; // The number of entries a position can be stored in (the least recently used one is replaced)
+
+	struct FileHeader
+	{
+		uint64_t magic; // Always RESULT_CACHE_FILE_MAGIC
+		uint32_t version; // The version of the file format
+		uint32_t entrySize; // The size of an entry in bytes
+		uint64_t numberOfEntries; // The number of entries following the header
+		uint64_t zobristSignature; // Signature of the zobrist hashes the entries were stored with
+		uint64_t clock; // Incremented on every access, gives the entries their last used time
+		uint64_t reserved[3]; // Padding that keeps the entries 64 bytes aligned
+	};
+
+	struct Entry
+	{
+		uint64_t zobristHash; // The zobrist hash of the position
+		uint64_t lastUsed; // The clock value of the last access (0 for an empty entry)
+		int32_t score; // The score of the position
+		uint8_t activePlayer; // The side to move
+		uint8_t castlingRights; // The castling rights
+		uint8_t depth; // The depth the position was searched to
+		uint8_t principalVariationLength; // The number of principal variation moves
+		uint16_t principalVariation[MAX_PRINCIPAL_VARIATION_LENGTH]; // Raw principal variation moves
+		uint64_t evaluationSignature; // Signature of the evaluation the result was searched with (results of other evaluations are not found)
+	};
+
+	void* mapping; // The mapping of the cache file (header included)
+	FileHeader* header; // The header of the mapped file
+	Entry* entries; // The entries of the mapped file
+	Statistics statistics; // Hit and miss counters
+
+	static size_t getFileSize(); // The size of a cache file
+	Entry* findEntry(const uint64_t zobristHash, const int activePlayer, const uint8_t castlingRights, const uint64_t evaluationSignature) const; // Get the entry of the given position (nullptr if it is not cached)
+};
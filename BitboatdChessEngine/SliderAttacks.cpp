@@ -0,0 +1,179 @@
+#include "SliderAttacks.h"
+#include "BitboardGenerator.h"
+#include "SystemHelper.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <immintrin.h>
+
+// MSVC compiles intrinsics of every instruction set anywhere, GCC and Clang have to be told which functions may use them
+#if defined(_MSC_VER)
+#define TARGET_BMI2
+#else
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+
+static volatile uint64_t benchmarkResult; // The last attacks of the backend benchmark (keeps the lookups from being optimized away)
+
+// Shift the bitboard left by a positive or right by a negative amount
+template <int shift>
+static inline uint64_t shiftBy(const uint64_t bitboard)
+{
+	return shift > 0 ? bitboard << (shift > 0 ? shift : 0) : bitboard >> (shift < 0 ? -shift : 0);
+}
+
+// Extend the given squares in one direction over the empty squares (Kogge-Stone parallel prefix) and get the squares reached one step further.
+// The empty squares have to exclude the file the shift wraps into, the mask keeps the final step from wrapping
+template <int shift, uint64_t wrapMask>
+static inline uint64_t fillAttacks(uint64_t generator, uint64_t empty)
+{
+	empty &= wrapMask;
+	generator |= empty & shiftBy<shift>(generator);
+	empty &= shiftBy<shift>(empty);
+	generator |= empty & shiftBy<2 * shift>(generator);
+	empty &= shiftBy<2 * shift>(empty);
+	generator |= empty & shiftBy<4 * shift>(generator);
+	return shiftBy<shift>(generator) & wrapMask;
+}
+
+SliderAttacks::SliderAttacks()
+{
+	AttackTables::initialize();
+
+	this->backend = isSupported(Backend::PEXT) ? Backend::PEXT : Backend::MAGIC;
+}
+
+SliderAttacks::Backend SliderAttacks::getBackend() const
+{
+	return this->backend;
+}
+
+bool SliderAttacks::setBackend(const Backend backend)
+{
+	if (!isSupported(backend))
+		return false;
+
+	this->backend = backend;
+	return true;
+}
+
+TARGET_BMI2 uint64_t SliderAttacks::getRookAttacksPext(const int square, const uint64_t occupancy)
+{
+	return attackTables.rookPext[square].attacks[_pext_u64(occupancy, attackTables.rookPext[square].mask)];
+}
+
+TARGET_BMI2 uint64_t SliderAttacks::getBishopAttacksPext(const int square, const uint64_t occupancy)
+{
+	return attackTables.bishopPext[square].attacks[_pext_u64(occupancy, attackTables.bishopPext[square].mask)];
+}
+
+uint64_t SliderAttacks::getRookAttacksKoggeStone(const int square, const uint64_t occupancy)
+{
+	const uint64_t rook = 1ULL << square;
+	const uint64_t empty = ~occupancy;
+
+	return fillAttacks<8, ~0ULL>(rook, empty) |
+		fillAttacks<-8, ~0ULL>(rook, empty) |
+		fillAttacks<1, ~BitboardGenerator::FILE_A>(rook, empty) |
+		fillAttacks<-1, ~BitboardGenerator::FILE_H>(rook, empty);
+}
+
+uint64_t SliderAttacks::getBishopAttacksKoggeStone(const int square, const uint64_t occupancy)
+{
+	const uint64_t bishop = 1ULL << square;
+	const uint64_t empty = ~occupancy;
+
+	return fillAttacks<9, ~BitboardGenerator::FILE_A>(bishop, empty) |
+		fillAttacks<7, ~BitboardGenerator::FILE_H>(bishop, empty) |
+		fillAttacks<-7, ~BitboardGenerator::FILE_A>(bishop, empty) |
+		fillAttacks<-9, ~BitboardGenerator::FILE_H>(bishop, empty);
+}
+
+bool SliderAttacks::isSupported(const Backend backend)
+{
+	static const SystemHelper::CpuFeatures features = SystemHelper::getCpuFeatures();
+
+	return backend != Backend::PEXT || features.bmi2;
+}
+
+const char* SliderAttacks::getName(const Backend backend)
+{
+	switch (backend)
+	{
+	case Backend::PEXT:
+		return "PEXT";
+	case Backend::MAGIC:
+		return "Magic";
+	default:
+		return "KoggeStone";
+	}
+}
+
+bool SliderAttacks::getBackendByName(const std::string& name, Backend& backend)
+{
+	for (const Backend candidate : { Backend::PEXT, Backend::MAGIC, Backend::KOGGE_STONE })
+	{
+		if (name == getName(candidate))
+		{
+			backend = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+SliderAttacks::Backend SliderAttacks::getBest()
+{
+	static const Backend best = []()
+	{
+		SliderAttacks sliderAttacks;
+
+		// Random squares with about a third of the board occupied (the lookups of a middle game)
+		const int numberOfLookups = 1024;
+		int squares[numberOfLookups];
+		uint64_t occupancies[numberOfLookups];
+		std::mt19937_64 generator(1);
+		for (int i = 0; i < numberOfLookups; i++)
+		{
+			squares[i] = static_cast<int>(generator() & 63);
+			occupancies[i] = generator() & (generator() | generator()) & ~(1ULL << squares[i]);
+		}
+
+		Backend fastest = Backend::MAGIC;
+		long long fastestTime = LLONG_MAX;
+		for (const Backend backend : { Backend::PEXT, Backend::MAGIC, Backend::KOGGE_STONE })
+		{
+			if (!sliderAttacks.setBackend(backend))
+				continue;
+
+			// The best of a few runs, so an interruption does not decide the backend
+			long long time = LLONG_MAX;
+			for (int run = 0; run < 5; run++)
+			{
+				auto start = std::chrono::steady_clock::now();
+
+				// Every lookup depends on the previous one, as the lookups of move generation depend on the board
+				uint64_t attacks = 0;
+				for (int repetition = 0; repetition < 32; repetition++)
+					for (int i = 0; i < numberOfLookups; i++)
+						attacks = sliderAttacks.getRookAttacks(squares[i], occupancies[i] ^ (attacks & 1)) ^ sliderAttacks.getBishopAttacks(squares[i], occupancies[i] ^ (attacks & 2));
+
+				auto end = std::chrono::steady_clock::now();
+				time = std::min<long long>(time, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+				benchmarkResult = attacks;
+			}
+
+			if (time < fastestTime)
+			{
+				fastestTime = time;
+				fastest = backend;
+			}
+		}
+
+		return fastest;
+	}();
+
+	return best;
+}
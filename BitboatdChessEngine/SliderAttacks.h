@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "AttackTables.h"
+
+// Rook and bishop attacks for any occupancy. PEXT indexing is the fastest where the instruction is implemented in hardware, but it is microcoded
+// and very slow on AMD Zen 1 and 2, so fancy magic bitboards and Kogge-Stone fills can be used instead. The fastest backend is chosen once at startup
+class SliderAttacks
+{
+public:
+	enum class Backend { PEXT, MAGIC, KOGGE_STONE };
+
+	SliderAttacks(); // Slider attacks constructor (builds the shared attack tables if they are not built yet, PEXT is used if the CPU supports it)
+
+	Backend getBackend() const; // Get the backend the attacks are looked up with
+	bool setBackend(const Backend backend); // Look up the attacks with the given backend (returns false if the CPU does not support it)
+
+	uint64_t getRookAttacks(const int square, const uint64_t occupancy) const; // Get the squares a rook on the given square attacks
+	uint64_t getBishopAttacks(const int square, const uint64_t occupancy) const; // Get the squares a bishop on the given square attacks
+
+	static bool isSupported(const Backend backend); // True if the host CPU can run the given backend
+	static const char* getName(const Backend backend); // Get the name of the given backend
+	static bool getBackendByName(const std::string& name, Backend& backend); // Get the backend of the given name (returns false if there is no such backend)
+	static Backend getBest(); // Get the fastest backend on the host CPU (chosen once per process by benchmarking the supported backends)
+
+private:
+	Backend backend; // The backend the attacks are looked up with
+
+	// The PEXT lookups are compiled for BMI2 on their own, so the rest of the engine runs on CPUs without it
+	static uint64_t getRookAttacksPext(const int square, const uint64_t occupancy); // Get the rook attacks from the PEXT indexed table
+	static uint64_t getBishopAttacksPext(const int square, const uint64_t occupancy); // Get the bishop attacks from the PEXT indexed table
+	static uint64_t getRookAttacksKoggeStone(const int square, const uint64_t occupancy); // Get the rook attacks by filling the empty squares in the 4 line directions
+	static uint64_t getBishopAttacksKoggeStone(const int square, const uint64_t occupancy); // Get the bishop attacks by filling the empty squares in the 4 diagonal directions
+};
+
+inline uint64_t SliderAttacks::getRookAttacks(const int square, const uint64_t occupancy) const
+{
+	// The backend does not change during a search, so the branch is always predicted
+	switch (this->backend)
+	{
+	case Backend::PEXT:
+		return getRookAttacksPext(square, occupancy);
+	case Backend::MAGIC:
+		return attackTables.rookMagic[square].attacks[((occupancy & attackTables.rookMagic[square].mask) * attackTables.rookMagic[square].magic) >> attackTables.rookMagic[square].shift];
+	default:
+		return getRookAttacksKoggeStone(square, occupancy);
+	}
+}
+
+inline uint64_t SliderAttacks::getBishopAttacks(const int square, const uint64_t occupancy) const
+{
+	switch (this->backend)
+	{
+	case Backend::PEXT:
+		return getBishopAttacksPext(square, occupancy);
+	case Backend::MAGIC:
+		return attackTables.bishopMagic[square].attacks[((occupancy & attackTables.bishopMagic[square].mask) * attackTables.bishopMagic[square].magic) >> attackTables.bishopMagic[square].shift];
+	default:
+		return getBishopAttacksKoggeStone(square, occupancy);
+	}
+}
@@ -0,0 +1,545 @@
+#include "SystemHelper.h"
+#include <new>
+#include <cstdint>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <intrin.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <cpuid.h>
+#endif
+
+// Run the cpuid instruction for the given leaf and subleaf (the registers are returned in the order eax, ebx, ecx, edx)
+static void cpuid(const unsigned int leaf, const unsigned int subleaf, unsigned int registers[4])
+{
+#if defined(_WIN32)
+	__cpuidex(reinterpret_cast<int*>(registers), leaf, subleaf);
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Read the extended control register that tells which register states the operating system saves on context switches
+static uint64_t xgetbv()
+{
+#if defined(_WIN32)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+#if defined(__linux__)
+// Memory policies understood by the mbind system call (see <numaif.h>)
+constexpr int MPOL_PREFERRED_POLICY = 1;
+constexpr int MPOL_INTERLEAVE_POLICY = 3;
+
+// Parse a list in the format used by sysfs (for example "0-3,8-11") into the numbers it contains
+static std::vector<int> parseSysfsList(const std::string& list)
+{
+	std::vector<int> numbers;
+	int i = 0;
+
+	while (i < list.size())
+	{
+		// Get the first number of the range
+		int first = 0;
+		while (i < list.size() && '0' <= list[i] && list[i] <= '9')
+		{
+			first = first * 10 + list[i] - '0';
+			i++;
+		}
+
+		// Get the last number of the range (if there is one)
+		int last = first;
+		if (i < list.size() && list[i] == '-')
+		{
+			i++;
+			last = 0;
+			while (i < list.size() && '0' <= list[i] && list[i] <= '9')
+			{
+				last = last * 10 + list[i] - '0';
+				i++;
+			}
+		}
+
+		for (int number = first; number <= last; number++)
+			numbers.push_back(number);
+
+		// Skip the separator
+		while (i < list.size() && !('0' <= list[i] && list[i] <= '9'))
+			i++;
+	}
+
+	return numbers;
+}
+
+// Read the first line of a sysfs file
+static std::string readSysfsLine(const std::string& path)
+{
+	std::ifstream file(path);
+	std::string line;
+	std::getline(file, line);
+
+	return line;
+}
+
+// Apply a memory policy to a range of pages that has not been touched yet
+static void applyMemoryPolicy(void* memory, const size_t size, const int policy, const unsigned long nodeMask)
+{
+	// The policy is only a placement hint, so a failure (for example on a kernel without NUMA support) is ignored
+	syscall(SYS_mbind, memory, size, policy, &nodeMask, sizeof(nodeMask) * 8 + 1, 0);
+}
+
+// Map zeroed anonymous memory (pages are only placed on a node when first touched)
+static void* mapAnonymousMemory(const size_t size)
+{
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		throw std::bad_alloc();
+
+	return memory;
+}
+#endif
+
+int SystemHelper::getNumberOfNumaNodes()
+{
+#if defined(_WIN32)
+	ULONG highestNode = 0;
+	if (!GetNumaHighestNodeNumber(&highestNode))
+		return 1;
+
+	return highestNode + 1;
+#elif defined(__linux__)
+	std::vector<int> nodes = parseSysfsList(readSysfsLine("/sys/devices/system/node/online"));
+	if (nodes.empty())
+		return 1;
+
+	return nodes.back() + 1;
+#else
+	return 1;
+#endif
+}
+
+std::vector<int> SystemHelper::getNumaNodeCpus(const int node)
+{
+	std::vector<int> cpus;
+
+#if defined(_WIN32)
+	ULONGLONG processorMask = 0;
+	if (GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &processorMask))
+		for (int cpu = 0; cpu < 64; cpu++)
+			if (processorMask & (1ULL << cpu))
+				cpus.push_back(cpu);
+#elif defined(__linux__)
+	cpus = parseSysfsList(readSysfsLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+#endif
+
+	return cpus;
+}
+
+bool SystemHelper::bindCurrentThreadToNumaNode(const int node)
+{
+	std::vector<int> cpus = getNumaNodeCpus(node);
+	if (cpus.empty())
+		return false;
+
+#if defined(_WIN32)
+	DWORD_PTR affinityMask = 0;
+	for (int cpu : cpus)
+		affinityMask |= static_cast<DWORD_PTR>(1) << cpu;
+
+	return SetThreadAffinityMask(GetCurrentThread(), affinityMask) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (int cpu : cpus)
+		CPU_SET(cpu, &cpuSet);
+
+	// A pid of 0 refers to the calling thread
+	return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#else
+	return false;
+#endif
+}
+
+bool SystemHelper::unbindCurrentThread()
+{
+#if defined(_WIN32)
+	DWORD_PTR processAffinityMask = 0, systemAffinityMask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processAffinityMask, &systemAffinityMask))
+		return false;
+
+	return SetThreadAffinityMask(GetCurrentThread(), processAffinityMask) != 0;
+#elif defined(__linux__)
+	const long numberOfCpus = sysconf(_SC_NPROCESSORS_CONF);
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (long cpu = 0; cpu < numberOfCpus && cpu < CPU_SETSIZE; cpu++)
+		CPU_SET(cpu, &cpuSet);
+
+	// The kernel drops the CPUs that are offline or outside the cpuset of the process
+	return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#else
+	return true;
+#endif
+}
+
+void* SystemHelper::allocateLargeMemory(const size_t size)
+{
+#if defined(_WIN32)
+	void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#elif defined(__linux__)
+	return mapAnonymousMemory(size);
+#else
+	void* memory = std::calloc(1, size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#endif
+}
+
+void* SystemHelper::allocateInterleaved(const size_t size)
+{
+#if defined(_WIN32)
+	// Windows has no interleaving policy, the pages are placed where they are first touched
+	void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#elif defined(__linux__)
+	void* memory = mapAnonymousMemory(size);
+
+	// Spread the pages over every node, so no single memory controller serves all the probes
+	const int numberOfNodes = getNumberOfNumaNodes();
+	if (numberOfNodes > 1)
+		applyMemoryPolicy(memory, size, MPOL_INTERLEAVE_POLICY, numberOfNodes >= 64 ? ~0UL : (1UL << numberOfNodes) - 1);
+
+	return memory;
+#else
+	void* memory = std::calloc(1, size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#endif
+}
+
+void* SystemHelper::allocateOnNumaNode(const size_t size, const int node)
+{
+#if defined(_WIN32)
+	void* memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+	if (memory == nullptr)
+		memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#elif defined(__linux__)
+	void* memory = mapAnonymousMemory(size);
+
+	if (0 <= node && node < 64)
+		applyMemoryPolicy(memory, size, MPOL_PREFERRED_POLICY, 1UL << node);
+
+	return memory;
+#else
+	void* memory = std::calloc(1, size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	return memory;
+#endif
+}
+
+void SystemHelper::freeLargeMemory(void* memory, const size_t size)
+{
+	if (memory == nullptr)
+		return;
+
+#if defined(_WIN32)
+	VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+	munmap(memory, size);
+#else
+	std::free(memory);
+#endif
+}
+
+void* SystemHelper::attachSharedMemory(const std::string& name, const size_t size)
+{
+#if defined(_WIN32)
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), ("Local\\" + name).c_str());
+	if (mapping == nullptr)
+		return nullptr;
+
+	// The view keeps the mapping alive after the handle is closed
+	void* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	CloseHandle(mapping);
+
+	return memory;
+#elif defined(__linux__)
+	// POSIX shared memory object names start with a slash
+	const std::string objectName = (!name.empty() && name[0] == '/') ? name : "/" + name;
+
+	int descriptor = shm_open(objectName.c_str(), O_RDWR | O_CREAT, 0666);
+	if (descriptor < 0)
+		return nullptr;
+
+	// Size a newly created object, and refuse an existing object of a different size
+	struct stat objectStatus;
+	if (fstat(descriptor, &objectStatus) != 0 || (objectStatus.st_size != 0 && static_cast<size_t>(objectStatus.st_size) != size) ||
+		(objectStatus.st_size == 0 && ftruncate(descriptor, size) != 0))
+	{
+		close(descriptor);
+		return nullptr;
+	}
+
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+	// Spread the pages that are not placed yet over every node
+	const int numberOfNodes = getNumberOfNumaNodes();
+	if (numberOfNodes > 1)
+		applyMemoryPolicy(memory, size, MPOL_INTERLEAVE_POLICY, numberOfNodes >= 64 ? ~0UL : (1UL << numberOfNodes) - 1);
+
+	return memory;
+#else
+	return nullptr;
+#endif
+}
+
+void SystemHelper::detachSharedMemory(void* memory, const size_t size)
+{
+	if (memory == nullptr)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(memory);
+#elif defined(__linux__)
+	munmap(memory, size);
+#endif
+}
+
+void* SystemHelper::mapFile(const std::string& path, size_t& size)
+{
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return nullptr;
+
+	// The view keeps the mapping alive after the handle is closed
+	void* memory = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+	CloseHandle(mapping);
+
+	return memory;
+#elif defined(__linux__)
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return nullptr;
+
+	struct stat fileStatus;
+	if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close(descriptor);
+		return nullptr;
+	}
+	size = static_cast<size_t>(fileStatus.st_size);
+
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+	return memory;
+#else
+	return nullptr;
+#endif
+}
+
+void* SystemHelper::mapPersistentFile(const std::string& path, const size_t size)
+{
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	// Refuse an existing file of a different size (mapping a new file extends it to the given size)
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart != 0 && static_cast<size_t>(fileSize.QuadPart) != size))
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return nullptr;
+
+	// The view keeps the mapping alive after the handle is closed
+	void* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	CloseHandle(mapping);
+
+	return memory;
+#elif defined(__linux__)
+	int descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+	if (descriptor < 0)
+		return nullptr;
+
+	// Size a newly created file, and refuse an existing file of a different size
+	struct stat fileStatus;
+	if (fstat(descriptor, &fileStatus) != 0 || (fileStatus.st_size != 0 && static_cast<size_t>(fileStatus.st_size) != size) ||
+		(fileStatus.st_size == 0 && ftruncate(descriptor, size) != 0))
+	{
+		close(descriptor);
+		return nullptr;
+	}
+
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+	return memory;
+#else
+	return nullptr;
+#endif
+}
+
+void SystemHelper::unmapFile(void* memory, const size_t size)
+{
+	if (memory == nullptr)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(memory);
+#elif defined(__linux__)
+	munmap(memory, size);
+#endif
+}
+
+bool SystemHelper::isSameFile(const std::string& firstPath, const std::string& secondPath)
+{
+#if defined(_WIN32)
+	// Files are identified by their volume and index (the same file can be reached through many paths)
+	BY_HANDLE_FILE_INFORMATION information[2];
+	const std::string* paths[2] = { &firstPath, &secondPath };
+	for (int i = 0; i < 2; i++)
+	{
+		HANDLE file = CreateFileA(paths[i]->c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		const bool success = GetFileInformationByHandle(file, &information[i]) != 0;
+		CloseHandle(file);
+		if (!success)
+			return false;
+	}
+
+	return information[0].dwVolumeSerialNumber == information[1].dwVolumeSerialNumber &&
+		information[0].nFileIndexHigh == information[1].nFileIndexHigh && information[0].nFileIndexLow == information[1].nFileIndexLow;
+#elif defined(__linux__)
+	// Files are identified by their device and inode (the same file can be reached through many paths)
+	struct stat firstStatus, secondStatus;
+	if (stat(firstPath.c_str(), &firstStatus) != 0 || stat(secondPath.c_str(), &secondStatus) != 0)
+		return false;
+
+	return firstStatus.st_dev == secondStatus.st_dev && firstStatus.st_ino == secondStatus.st_ino;
+#else
+	return firstPath == secondPath;
+#endif
+}
+
+bool SystemHelper::replaceFile(const std::string& sourcePath, const std::string& destinationPath)
+{
+#if defined(_WIN32)
+	return MoveFileExA(sourcePath.c_str(), destinationPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	// Processes that still have the old file open or mapped keep its contents
+	return std::rename(sourcePath.c_str(), destinationPath.c_str()) == 0;
+#endif
+}
+
+const void* SystemHelper::getResource(const std::string& name, size_t& size)
+{
+#if defined(_WIN32)
+	HRSRC resource = FindResourceA(nullptr, name.c_str(), MAKEINTRESOURCEA(10)); // RT_RCDATA
+	if (resource == nullptr)
+		return nullptr;
+
+	// Resources stay loaded for the lifetime of the process, nothing has to be released
+	HGLOBAL handle = LoadResource(nullptr, resource);
+	if (handle == nullptr)
+		return nullptr;
+
+	size = SizeofResource(nullptr, resource);
+	return LockResource(handle);
+#else
+	(void)name;
+	size = 0;
+	return nullptr;
+#endif
+}
+
+SystemHelper::CpuFeatures SystemHelper::getCpuFeatures()
+{
+	CpuFeatures features = {};
+	unsigned int registers[4];
+
+	cpuid(0, 0, registers);
+	const unsigned int highestLeaf = registers[0];
+
+	cpuid(1, 0, registers);
+	features.sse41 = (registers[2] >> 19) & 1;
+	features.popcnt = (registers[2] >> 23) & 1;
+
+	// The AVX instructions can only be used if the operating system saves the upper halves of the registers (and the AVX-512 mask and upper registers)
+	const bool osxsave = (registers[2] >> 27) & 1;
+	const uint64_t savedStates = osxsave ? xgetbv() : 0;
+	const bool avxStateSaved = (savedStates & 0x06) == 0x06;
+	const bool avx512StateSaved = (savedStates & 0xE6) == 0xE6;
+
+	if (highestLeaf >= 7)
+	{
+		cpuid(7, 0, registers);
+		features.avx2 = avxStateSaved && ((registers[1] >> 5) & 1);
+		features.bmi2 = (registers[1] >> 8) & 1;
+		features.avx512 = avx512StateSaved && ((registers[1] >> 16) & 1) && ((registers[1] >> 30) & 1);
+	}
+
+	return features;
+}
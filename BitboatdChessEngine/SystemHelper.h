@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class SystemHelper
+{
+public:
+	// Instruction set extensions supported by both the CPU and the operating system
+	struct CpuFeatures
+	{
+		bool sse41; // SSE4.1
+		bool popcnt; // POPCNT
+		bool avx2; // AVX2 (the operating system saves the AVX registers)
+		bool bmi2; // BMI2 (PEXT and PDEP)
+		bool avx512; // AVX-512 Foundation and Byte and Word instructions (the operating system saves the AVX-512 registers)
+	};
+
+	// Query the extensions of the host CPU with the cpuid instruction
+	static CpuFeatures getCpuFeatures();
+
+	// Get the number of NUMA nodes of the host (1 on hosts without NUMA support)
+	static int getNumberOfNumaNodes();
+	// Get the CPUs that belong to the given NUMA node
+	static std::vector<int> getNumaNodeCpus(const int node);
+	// Bind the calling thread to the CPUs of the given NUMA node (returns true on success)
+	static bool bindCurrentThreadToNumaNode(const int node);
+	// Let the calling thread run on every CPU of the process again (returns true on success)
+	static bool unbindCurrentThread();
+
+	// Allocate zeroed memory whose pages are placed on the node of the thread that first touches them
+	static void* allocateLargeMemory(const size_t size);
+	// Allocate zeroed memory with its pages interleaved across all NUMA nodes (only on Linux, elsewhere it is placed like allocateLargeMemory)
+	static void* allocateInterleaved(const size_t size);
+	// Allocate zeroed memory with its pages placed on the given NUMA node
+	static void* allocateOnNumaNode(const size_t size, const int node);
+	// Free memory obtained from allocateLargeMemory, allocateInterleaved or allocateOnNumaNode
+	static void freeLargeMemory(void* memory, const size_t size);
+
+	// Map the named shared memory object (creating it zeroed if it does not exist). Returns nullptr if it can not be mapped with the given size
+	static void* attachSharedMemory(const std::string& name, const size_t size);
+	// Unmap memory obtained from attachSharedMemory (the object itself stays available to other processes)
+	static void detachSharedMemory(void* memory, const size_t size);
+
+	// Map the given file copy-on-write (changes stay private to the process). Returns nullptr if the file can not be mapped
+	static void* mapFile(const std::string& path, size_t& size);
+	// Map the given file read-write so changes are written back to it (creating it zeroed with the given size if it does not exist). Returns nullptr if the file has another size or can not be mapped
+	static void* mapPersistentFile(const std::string& path, const size_t size);
+	// Unmap memory obtained from mapFile or mapPersistentFile
+	static void unmapFile(void* memory, const size_t size);
+	// Check if the two paths name the same file (false if either does not exist)
+	static bool isSameFile(const std::string& firstPath, const std::string& secondPath);
+	// Rename the source file to the destination, replacing an existing destination in one step (returns true on success)
+	static bool replaceFile(const std::string& sourcePath, const std::string& destinationPath);
+
+	// Get the named binary resource linked into the executable (Windows RCDATA resources). Returns nullptr if there is no such resource
+	static const void* getResource(const std::string& name, size_t& size);
+};
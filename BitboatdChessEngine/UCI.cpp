@@ -1,4 +1,10 @@
 #include "UCI.h"
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <climits>
+#include <memory>
+#include <thread>
 
 std::string UCI::identifyCommand(const std::string& commandLine)
 {
@@ -22,6 +28,7 @@ std::string UCI::identifyCommand(const std::string& commandLine)
 void UCI::handleGo(const std::string& commandLine)
 {
 	int i = 3;
+	int depth = 0;
 
 	while (i < commandLine.size())
 	{
@@ -57,11 +64,30 @@ void UCI::handleGo(const std::string& commandLine)
 			this->chessEngine.setWhiteIncrement(value);
 		else if (option == "binc")
 			this->chessEngine.setBlackIncrement(value);
+		else if (option == "depth")
+			depth = value;
 	}
 
-	ChessEngine::SearchResult result = this->chessEngine.getBestMove();
+	// A fixed depth search ignores the clock (and can be answered from the result cache)
+	ChessEngine::SearchResult result = depth > 0 ? this->chessEngine.getBestMove(depth) : this->chessEngine.getBestMove();
+
+	MoveList principalVariation = this->chessEngine.getPrincipalVariation();
 	std::cout << "info" << " depth " << this->chessEngine.getDepthReached() << " score cp " << result.score
-		<< " time " << this->chessEngine.getTimeUsed() << " nodes " << this->chessEngine.getNumberOfNodesVisited() << "\n";
+		<< " time " << this->chessEngine.getTimeUsed() << " nodes " << this->chessEngine.getNumberOfNodesVisited();
+	if (principalVariation.numberOfMoves > 0)
+	{
+		std::cout << " pv";
+		for (int j = 0; j < principalVariation.numberOfMoves; j++)
+			std::cout << " " << principalVariation.moves[j].toString();
+	}
+	std::cout << "\n";
+
+	if (!this->resultCacheFile.empty())
+	{
+		ResultCache::Statistics statistics = this->chessEngine.getResultCacheStatistics();
+		std::cout << "info string ResultCache hits " << statistics.hits << " misses " << statistics.misses << " stores " << statistics.stores << "\n";
+	}
+
 	std::cout << "bestmove " << result.move.toString() << "\n";
 }
 
@@ -70,6 +96,16 @@ void UCI::handleUci() const
 	std::cout << "id name " << ENGINE_NAME << "\n";
 	std::cout << "id author " << AUTHOR << "\n";
 
+	std::cout << "option name NumaNode type spin default -1 min -1 max " << SystemHelper::getNumberOfNumaNodes() - 1 << "\n";
+	std::cout << "option name SharedHash type string default <empty>\n";
+	std::cout << "option name HashFile type string default <empty>\n";
+	std::cout << "option name SaveHashToFile type button\n";
+	std::cout << "option name LoadHashFromFile type button\n";
+	std::cout << "option name TwoTierHash type check default true\n";
+	std::cout << "option name ResultCacheFile type string default <empty>\n";
+	std::cout << "option name EvalFile type string default " << (NNUE::hasEmbeddedNetwork() ? NNUE_EMBEDDED_NETWORK : "<empty>") << "\n";
+	std::cout << "option name SliderAttacks type combo default Auto var Auto var PEXT var Magic var KoggeStone\n";
+
 	std::cout << "uciok\n";
 }
 
@@ -158,12 +194,491 @@ void UCI::handleStop()
 	this->chessEngine.stopCurrentSearch();
 }
 
+void UCI::handleSetOption(const std::string& commandLine)
+{
+	// The command has the form "setoption name <name> [value <value>]"
+	size_t nameStart = commandLine.find(" name ");
+	if (nameStart == std::string::npos)
+		return;
+	nameStart += 6;
+
+	size_t valueStart = commandLine.find(" value ", nameStart);
+	std::string name = commandLine.substr(nameStart, valueStart == std::string::npos ? std::string::npos : valueStart - nameStart);
+	std::string value = valueStart == std::string::npos ? "" : commandLine.substr(valueStart + 7);
+
+	// Get rid of trailing spaces
+	while (!name.empty() && name.back() == ' ')
+		name.pop_back();
+	while (!value.empty() && value.back() == ' ')
+		value.pop_back();
+
+	if (name == "NumaNode")
+	{
+		// Get the node (a negative value removes the node preference)
+		int i = 0, sign = 1, node = 0;
+		if (i < value.size() && value[i] == '-')
+		{
+			sign = -1;
+			i++;
+		}
+		while (i < value.size() && '0' <= value[i] && value[i] <= '9')
+		{
+			node = node * 10 + value[i] - '0';
+			i++;
+		}
+
+		if (!this->chessEngine.setNumaNode(sign < 0 ? -1 : node))
+			std::cout << "info string NumaNode " << value << " is not available on this host\n";
+	}
+	else if (name == "SharedHash")
+	{
+		// The name of the shared memory object holding the transposition table (empty for a private table)
+		if (value == "<empty>")
+			value = "";
+
+		if (!this->chessEngine.setSharedTranspositionTable(value))
+			std::cout << "info string Could not attach to the shared hash " << value << "\n";
+	}
+	else if (name == "TwoTierHash")
+	{
+		this->chessEngine.setTwoTierTranspositionTable(value == "true");
+	}
+	else if (name == "ResultCacheFile")
+	{
+		// The file keeping the results of finished searches (empty to stop caching)
+		this->resultCacheFile = value == "<empty>" ? "" : value;
+
+		if (!this->chessEngine.setResultCacheFile(this->resultCacheFile))
+		{
+			std::cout << "info string Could not open the result cache " << this->resultCacheFile << "\n";
+			this->resultCacheFile = "";
+		}
+	}
+	else if (name == "EvalFile")
+	{
+		// The network file (<embedded> for the network built into the binary, empty to go back to the hand written evaluation)
+		if (value == "<empty>")
+			value = "";
+
+		if (!this->chessEngine.setEvalFile(value))
+			std::cout << "info string Could not load the network " << value << " (missing or incompatible file)\n";
+		else if (!value.empty())
+			std::cout << "info string Network loaded from " << value << " (" << NNUEKernels::getBest().name << " kernels)\n";
+	}
+	else if (name == "SliderAttacks")
+	{
+		// The rook and bishop movement backend (Auto for the fastest one on this host)
+		SliderAttacks::Backend backend = SliderAttacks::getBest();
+		if (value != "Auto" && !SliderAttacks::getBackendByName(value, backend))
+			std::cout << "info string Unknown slider attacks backend " << value << "\n";
+		else if (!this->chessEngine.setSliderAttacks(backend))
+			std::cout << "info string The " << value << " slider attacks are not supported by this CPU\n";
+		else
+			std::cout << "info string Slider attacks looked up with " << SliderAttacks::getName(backend) << "\n";
+	}
+	else if (name == "HashFile")
+	{
+		this->hashFile = value == "<empty>" ? "" : value;
+	}
+	else if (name == "SaveHashToFile")
+	{
+		if (this->chessEngine.saveTranspositionTable(this->hashFile))
+			std::cout << "info string Hash saved to " << this->hashFile << "\n";
+		else
+			std::cout << "info string Could not save the hash to " << this->hashFile << " (not writable, or the file the hash is loaded from)\n";
+	}
+	else if (name == "LoadHashFromFile")
+	{
+		if (this->chessEngine.loadTranspositionTable(this->hashFile))
+			std::cout << "info string Hash loaded from " << this->hashFile << "\n";
+		else
+			std::cout << "info string Could not load the hash from " << this->hashFile << " (missing, stale or incompatible file)\n";
+	}
+}
+
+void UCI::handleBench(const std::string& commandLine)
+{
+	int i = 5;
+
+	// Get rid of spaces
+	while (i < commandLine.size() && commandLine[i] == ' ')
+		i++;
+
+	// Get the depth (optional)
+	int depth = 0;
+	while (i < commandLine.size() && '0' <= commandLine[i] && commandLine[i] <= '9')
+	{
+		depth = depth * 10 + commandLine[i] - '0';
+		i++;
+	}
+	if (depth == 0)
+		depth = BENCH_DEPTH;
+
+	unsigned long long totalNodes = 0;
+	long long totalTime = 0;
+	ChessEngine::TranspositionTableStatistics totalStatistics;
+	ChessEngine::EvaluationCacheStatistics totalEvaluationCacheStatistics;
+	ChessEngine::LazyEvaluationStatistics totalLazyEvaluationStatistics;
+
+	const int numberOfPositions = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+	for (int position = 0; position < numberOfPositions; position++)
+	{
+		this->chessEngine.loadFENPosition(BENCH_POSITIONS[position]);
+		this->chessEngine.clearTranspositionTable();
+		this->chessEngine.clearMoveOrderingTables();
+
+		auto start = std::chrono::steady_clock::now();
+		ChessEngine::SearchResult result = this->chessEngine.getBestMove(depth);
+		auto stop = std::chrono::steady_clock::now();
+
+		long long time = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+		totalNodes += this->chessEngine.getNumberOfNodesVisited();
+		totalTime += time;
+
+		ChessEngine::TranspositionTableStatistics statistics = this->chessEngine.getTranspositionTableStatistics();
+		totalStatistics.shallowProbes += statistics.shallowProbes;
+		totalStatistics.shallowHits += statistics.shallowHits;
+		totalStatistics.shallowUsableHits += statistics.shallowUsableHits;
+		totalStatistics.mainProbes += statistics.mainProbes;
+		totalStatistics.mainHits += statistics.mainHits;
+		totalStatistics.mainUsableHits += statistics.mainUsableHits;
+
+		ChessEngine::EvaluationCacheStatistics evaluationCacheStatistics = this->chessEngine.getEvaluationCacheStatistics();
+		totalEvaluationCacheStatistics.probes += evaluationCacheStatistics.probes;
+		totalEvaluationCacheStatistics.hits += evaluationCacheStatistics.hits;
+
+		ChessEngine::LazyEvaluationStatistics lazyEvaluationStatistics = this->chessEngine.getLazyEvaluationStatistics();
+		totalLazyEvaluationStatistics.lazyExits += lazyEvaluationStatistics.lazyExits;
+		totalLazyEvaluationStatistics.fullEvaluations += lazyEvaluationStatistics.fullEvaluations;
+		totalLazyEvaluationStatistics.lazyCycles += lazyEvaluationStatistics.lazyCycles;
+		totalLazyEvaluationStatistics.fullCycles += lazyEvaluationStatistics.fullCycles;
+
+		std::cout << "Position " << position + 1 << "/" << numberOfPositions << ": bestmove " << result.move.toString()
+			<< " nodes " << this->chessEngine.getNumberOfNodesVisited() << " time " << time << "\n";
+	}
+
+	std::cout << "===========================\n";
+	std::cout << "NUMA node       : " << this->chessEngine.getNumaNode() << " (of " << SystemHelper::getNumberOfNumaNodes() << ")\n";
+	std::cout << "Total time (ms) : " << totalTime << "\n";
+	std::cout << "Nodes searched  : " << totalNodes << "\n";
+	std::cout << "Nodes/second    : " << totalNodes * 1000 / std::max(totalTime, 1LL) << "\n";
+	std::cout << "Shallow TT      : " << totalStatistics.shallowHits << "/" << totalStatistics.shallowProbes << " probes hit, " << totalStatistics.shallowUsableHits << " deep enough\n";
+	std::cout << "Main TT         : " << totalStatistics.mainHits << "/" << totalStatistics.mainProbes << " probes hit, " << totalStatistics.mainUsableHits << " deep enough\n";
+	std::cout << "Eval cache      : " << totalEvaluationCacheStatistics.hits << "/" << totalEvaluationCacheStatistics.probes << " probes hit\n";
+
+	// The time saved is estimated from the average cost of a full evaluation and of an early exit
+	const ChessEngine::LazyEvaluationStatistics& lazy = totalLazyEvaluationStatistics;
+	const double fullCost = static_cast<double>(lazy.fullCycles) / std::max(lazy.fullEvaluations, 1ULL);
+	const double lazyCost = static_cast<double>(lazy.lazyCycles) / std::max(lazy.lazyExits, 1ULL);
+	const double savedCycles = lazy.lazyExits * std::max(fullCost - lazyCost, 0.0);
+	std::cout << "Lazy eval       : " << lazy.lazyExits << "/" << lazy.lazyExits + lazy.fullEvaluations << " evaluations exited early, "
+		<< static_cast<int>(100.0 * savedCycles / std::max(savedCycles + lazy.fullCycles + lazy.lazyCycles, 1.0)) << "% of evaluation time saved\n";
+}
+
+void UCI::handlePerftBench(const std::string& commandLine)
+{
+	int i = 10;
+
+	// Get rid of spaces
+	while (i < commandLine.size() && commandLine[i] == ' ')
+		i++;
+
+	// Get the depth (optional)
+	int depth = 0;
+	while (i < commandLine.size() && '0' <= commandLine[i] && commandLine[i] <= '9')
+	{
+		depth = depth * 10 + commandLine[i] - '0';
+		i++;
+	}
+	if (depth == 0)
+		depth = PERFT_BENCH_DEPTH;
+
+	unsigned long long totalNodes = 0;
+	long long totalTime = 0;
+
+	const int numberOfPositions = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+	for (int position = 0; position < numberOfPositions; position++)
+	{
+		this->chessEngine.loadFENPosition(BENCH_POSITIONS[position]);
+
+		auto start = std::chrono::steady_clock::now();
+		// Every leaf is made and undone, so the make/undo speed is measured as well
+		unsigned long long nodes = this->chessEngine.perft(depth, false);
+		auto stop = std::chrono::steady_clock::now();
+
+		long long time = std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
+		totalNodes += nodes;
+		totalTime += time;
+
+		std::cout << "Position " << position + 1 << "/" << numberOfPositions << ": perft " << depth << " nodes " << nodes << " time " << time / 1000 << "\n";
+	}
+
+	std::cout << "===========================\n";
+	std::cout << "Total time (ms) : " << totalTime / 1000 << "\n";
+	std::cout << "Nodes           : " << totalNodes << "\n";
+	std::cout << "Nodes/second    : " << totalNodes * 1000000 / std::max(totalTime, 1LL) << "\n";
+}
+
+void UCI::handlePerft(const std::string& commandLine)
+{
+	// The command has the form "perft <depth> [threads <n>] [hash <megabytes>]" (all hardware threads and no hash table by default)
+	std::istringstream arguments(commandLine);
+	std::string command, option;
+	int depth = 1;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	int hashSize = 0;
+	arguments >> command >> depth;
+
+	while (arguments >> option)
+	{
+		if (option == "threads")
+			arguments >> threads;
+		else if (option == "hash")
+			arguments >> hashSize;
+	}
+
+	if (depth < 0)
+	{
+		std::cout << "info string The perft depth can not be negative\n";
+		return;
+	}
+
+	ChessEngine::PerftResult result = this->chessEngine.parallelPerft(depth, threads, true, hashSize);
+	if (result.hashTableReduced)
+		std::cout << "info string Could not allocate a " << hashSize << " MB perft hash table, used " << result.hashSizeInMegabytes << " MB\n";
+
+	// Nodes below every move, to compare with another move generator
+	for (const std::pair<Move, unsigned long long>& entry : result.divide)
+		std::cout << entry.first.toString() << ": " << entry.second << "\n";
+
+	std::cout << "===========================\n";
+	std::cout << "Total time (ms) : " << result.timeInMicroseconds / 1000 << "\n";
+	std::cout << "Nodes           : " << result.nodes << "\n";
+	std::cout << "Nodes/second    : " << result.nodes * 1000000 / std::max(result.timeInMicroseconds, 1LL) << "\n";
+}
+
+void UCI::handlePerftSuite(const std::string& commandLine)
+{
+	// The command has the form "perftsuite <epd file> [depth <n>] [threads <n>] [hash <megabytes>]" (depth limits the depths checked, all of them by default)
+	std::istringstream arguments(commandLine);
+	std::string command, path, option;
+	int maxDepth = INT_MAX;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	int hashSize = 0;
+	arguments >> command >> path;
+
+	while (arguments >> option)
+	{
+		if (option == "depth")
+			arguments >> maxDepth;
+		else if (option == "threads")
+			arguments >> threads;
+		else if (option == "hash")
+			arguments >> hashSize;
+	}
+
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "info string Could not open the perft suite " << path << "\n";
+		return;
+	}
+
+	// Every line holds a position followed by the expected node counts, as in "<fen> ;D1 20 ;D2 400 ;D3 8902"
+	struct SuitePosition
+	{
+		std::string fen; // The position
+		std::vector<std::pair<int, unsigned long long>> expectedNodes; // The expected number of leaf nodes at each depth
+		int numberOfMalformed; // The number of fields that could not be read
+	};
+
+	std::vector<SuitePosition> positions;
+	std::string line;
+	int lineNumber = 0;
+	int numberOfMalformed = 0;
+
+	auto isNumber = [](const std::string& text, const size_t maxLength)
+	{
+		if (text.empty() || text.size() > maxLength)
+			return false;
+		for (const char character : text)
+		{
+			if (character < '0' || '9' < character)
+				return false;
+		}
+		return true;
+	};
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream fields(line);
+		std::string fen, field;
+		std::getline(fields, fen, ';');
+		while (!fen.empty() && (fen.back() == ' ' || fen.back() == '\r'))
+			fen.pop_back();
+		if (fen.empty() || fen[0] == '#')
+			continue;
+
+		SuitePosition suitePosition;
+		suitePosition.fen = fen;
+		suitePosition.numberOfMalformed = 0;
+		while (std::getline(fields, field, ';'))
+		{
+			std::istringstream depthAndNodes(field);
+			std::string depthField, nodesField, rest;
+			if (!(depthAndNodes >> depthField))
+				continue; // Nothing after the last separator
+			while (!field.empty() && (field.back() == ' ' || field.back() == '\r'))
+				field.pop_back();
+
+			// Only positive depths are run, a bad field is reported instead of guessing what it meant
+			depthAndNodes >> nodesField;
+			const std::string depthNumber = depthField.substr(1);
+			if (depthField[0] != 'D' || !isNumber(depthNumber, 3) || std::atoi(depthNumber.c_str()) <= 0 || !isNumber(nodesField, 19) || depthAndNodes >> rest)
+			{
+				std::cout << "info string Malformed field \"" << field << "\" on line " << lineNumber << " of the perft suite\n";
+				suitePosition.numberOfMalformed++;
+				numberOfMalformed++;
+				continue;
+			}
+
+			suitePosition.expectedNodes.push_back(std::make_pair(std::atoi(depthNumber.c_str()), std::stoull(nodesField)));
+		}
+
+		positions.push_back(suitePosition);
+	}
+
+	unsigned long long totalNodes = 0;
+	long long totalTime = 0;
+	int numberOfPassed = 0;
+	int numberOfFailed = 0;
+	int numberOfSkipped = 0;
+
+	for (size_t position = 0; position < positions.size(); position++)
+	{
+		std::cout << "Position " << position + 1 << "/" << positions.size() << ": " << positions[position].fen << "\n";
+		this->chessEngine.loadFENPosition(positions[position].fen);
+
+		bool passed = true;
+		int numberOfChecked = 0;
+		for (const std::pair<int, unsigned long long>& expected : positions[position].expectedNodes)
+		{
+			if (expected.first > maxDepth)
+				continue;
+			numberOfChecked++;
+
+			ChessEngine::PerftResult result = this->chessEngine.parallelPerft(expected.first, threads, true, hashSize);
+			if (result.hashTableReduced)
+			{
+				// The rest of the suite uses the table that could be allocated
+				std::cout << "info string Could not allocate a " << hashSize << " MB perft hash table, using " << result.hashSizeInMegabytes << " MB\n";
+				hashSize = result.hashSizeInMegabytes;
+			}
+			totalNodes += result.nodes;
+			totalTime += result.timeInMicroseconds;
+
+			if (result.nodes == expected.second)
+			{
+				std::cout << "  perft " << expected.first << ": " << result.nodes << " ok\n";
+				continue;
+			}
+
+			// The nodes below every move, to compare with another move generator and find the wrong subtree
+			passed = false;
+			std::cout << "  perft " << expected.first << ": " << result.nodes << " expected " << expected.second << " FAILED\n";
+			for (const std::pair<Move, unsigned long long>& entry : result.divide)
+				std::cout << "    " << entry.first.toString() << ": " << entry.second << "\n";
+		}
+
+		// A position only passes if something was checked, one whose every field is malformed fails
+		if (!passed)
+		{
+			numberOfFailed++;
+		}
+		else if (numberOfChecked > 0)
+		{
+			numberOfPassed++;
+		}
+		else if (positions[position].expectedNodes.empty() && positions[position].numberOfMalformed > 0)
+		{
+			std::cout << "  FAILED (no well-formed expected count)\n";
+			numberOfFailed++;
+		}
+		else
+		{
+			std::cout << "  skipped (no expected count to check within the depth limit)\n";
+			numberOfSkipped++;
+		}
+	}
+
+	std::cout << "===========================\n";
+	std::cout << "Passed          : " << numberOfPassed << "/" << positions.size() << "\n";
+	std::cout << "Failed          : " << numberOfFailed << "\n";
+	std::cout << "Skipped         : " << numberOfSkipped << "\n";
+	std::cout << "Malformed fields: " << numberOfMalformed << "\n";
+	std::cout << "Total time (ms) : " << totalTime / 1000 << "\n";
+	std::cout << "Nodes           : " << totalNodes << "\n";
+	std::cout << "Nodes/second    : " << totalNodes * 1000000 / std::max(totalTime, 1LL) << "\n";
+}
+
+void UCI::handlePack(const std::string& commandLine)
+{
+	// The command has the form "pack <text file> <packed file>"
+	std::istringstream arguments(commandLine);
+	std::string command, textPath, packedPath;
+	arguments >> command >> textPath >> packedPath;
+
+	const long long numberOfPositions = NNUETrainer::packPositions(textPath, packedPath);
+	if (numberOfPositions < 0)
+		std::cout << "info string Could not pack " << textPath << " into " << packedPath << "\n";
+	else
+		std::cout << "info string Packed " << numberOfPositions << " positions into " << packedPath << "\n";
+}
+
+void UCI::handleTrain(const std::string& commandLine)
+{
+	// The command has the form "train <packed file> <network file> [epochs <n>] [batch <n>] [threads <n>] [lr <x>] [lambda <x>]"
+	std::istringstream arguments(commandLine);
+	std::string command, packedPath, networkPath;
+	arguments >> command >> packedPath >> networkPath;
+
+	NNUETrainer::Settings settings;
+	std::string option;
+	while (arguments >> option)
+	{
+		if (option == "epochs")
+			arguments >> settings.epochs;
+		else if (option == "batch")
+			arguments >> settings.batchSize;
+		else if (option == "threads")
+			arguments >> settings.threads;
+		else if (option == "lr")
+			arguments >> settings.learningRate;
+		else if (option == "lambda")
+			arguments >> settings.lambda;
+	}
+
+	// The trainer holds the positions and the Adam state, it only lives for the command
+	std::unique_ptr<NNUETrainer> trainer = std::make_unique<NNUETrainer>();
+	if (!trainer->loadPositions(packedPath) || trainer->getNumberOfPositions() == 0)
+	{
+		std::cout << "info string Could not load the training positions " << packedPath << "\n";
+		return;
+	}
+
+	std::cout << "info string Training on " << trainer->getNumberOfPositions() << " positions with " << settings.threads << " threads\n";
+	trainer->train(settings, networkPath);
+	std::cout << "info string Network written to " << networkPath << "\n";
+}
+
 void UCI::run()
 {
 	while (true)
 	{
 		std::string commandLine;
-		std::getline(std::cin, commandLine);
+		if (!std::getline(std::cin, commandLine)) // Stop when the input is closed
+			return;
 
 		std::string command = identifyCommand(commandLine);
 		if (command == "uci")
@@ -190,6 +705,34 @@ void UCI::run()
 		{
 			this->handleStop();
 		}
+		else if (command == "setoption")
+		{
+			this->handleSetOption(commandLine);
+		}
+		else if (command == "bench")
+		{
+			this->handleBench(commandLine);
+		}
+		else if (command == "perftbench")
+		{
+			this->handlePerftBench(commandLine);
+		}
+		else if (command == "perft")
+		{
+			this->handlePerft(commandLine);
+		}
+		else if (command == "perftsuite")
+		{
+			this->handlePerftSuite(commandLine);
+		}
+		else if (command == "pack")
+		{
+			this->handlePack(commandLine);
+		}
+		else if (command == "train")
+		{
+			this->handleTrain(commandLine);
+		}
 		else if (command == "quit")
 		{
 			return;
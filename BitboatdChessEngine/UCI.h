@@ -1,10 +1,26 @@
 #pragma once
 #include "ChessEngine.h"
+#include "NNUETrainer.h"
 #include <iostream>
 #include <string>
+#include <chrono>
 
 const std::string STARTING_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+// Positions searched by the "bench" command
+const std::string BENCH_POSITIONS[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+};
+
+const int BENCH_DEPTH = 7;
+const int PERFT_BENCH_DEPTH = 4; // The perft depth of the "perftbench" command (move generation and make/undo speed on the bench positions)
+
 const std::string ENGINE_NAME = "TDIEngine";
 const std::string AUTHOR = "Borgovan Alexandru";
 
@@ -12,6 +28,8 @@ class UCI
 {
 private:
 	ChessEngine chessEngine;
+	std::string hashFile; // The transposition table snapshot file used by the SaveHashToFile and LoadHashFromFile options
+	std::string resultCacheFile; // The result cache file (empty if results are not cached)
 
 	static std::string identifyCommand(const std::string& commandLine);
 
@@ -21,6 +39,13 @@ private:
 	void handleIsReady() const;
 	void handlePosition(const std::string& commandLine);
 	void handleStop();
+	void handleSetOption(const std::string& commandLine);
+	void handleBench(const std::string& commandLine);
+	void handlePerftBench(const std::string& commandLine);
+	void handlePerft(const std::string& commandLine);
+	void handlePerftSuite(const std::string& commandLine);
+	void handlePack(const std::string& commandLine);
+	void handleTrain(const std::string& commandLine);
 
 public:
 	void run();